@@ -123,3 +123,54 @@ BadBlockFile::write(const std::string           &filepath_,
 
   return 0;
 }
+
+std::string
+BadBlockFile::slow_filepath(const std::string &filepath_)
+{
+  if(filepath_ == "-")
+    return filepath_;
+
+  return (filepath_ + ".slow");
+}
+
+namespace l
+{
+  static
+  void
+  write_slow(std::ostream                 &stream_,
+             const std::vector<SlowBlock> &blocks_)
+  {
+    for(size_t i = 0, ei = blocks_.size(); i != ei; i++)
+      stream_ << blocks_[i].block << ' '
+              << blocks_[i].count << ' '
+              << (blocks_[i].usec / 1000)
+              << std::endl;
+  }
+}
+
+/*
+  One range per line: <first block> <block count> <latency in ms>
+*/
+int
+BadBlockFile::write_slow(const std::string            &filepath_,
+                         const std::vector<SlowBlock> &blocks_)
+{
+  if(filepath_ == "-")
+    {
+      l::write_slow(std::cout,blocks_);
+    }
+  else
+    {
+      std::ofstream file;
+
+      file.open(filepath_.c_str());
+      if(!file.is_open() || file.bad())
+        return -1;
+
+      l::write_slow(file,blocks_);
+
+      file.close();
+    }
+
+  return 0;
+}
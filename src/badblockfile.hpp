@@ -26,6 +26,13 @@
 
 #include <stdint.h>
 
+struct SlowBlock
+{
+  uint64_t block;
+  uint64_t count;
+  uint64_t usec;
+};
+
 namespace BadBlockFile
 {
   std::string filepath(const BlkDev &blkdev);
@@ -35,4 +42,9 @@ namespace BadBlockFile
 
   int write(const std::string           &filepath,
             const std::vector<uint64_t> &blocks);
+
+  std::string slow_filepath(const std::string &filepath);
+
+  int write_slow(const std::string            &filepath,
+                 const std::vector<SlowBlock> &blocks);
 };
@@ -30,9 +30,12 @@
 #include "bbf_security_erase.hpp"
 #include "bbf_write_uncorrectable.hpp"
 
+#include "blkdev.hpp"
 #include "errors.hpp"
+#include "ioprio.hpp"
 #include "options.hpp"
 #include "signals.hpp"
+#include "simdev.hpp"
 
 #include <iostream>
 #include <utility>
@@ -43,9 +46,27 @@ namespace l
   AppError
   process_instruction(const Options &opts_)
   {
+    int rv;
+    SimDev sim;
+
     if(opts_.quiet)
       std::cout.setstate(std::ios::failbit);
 
+    if(opts_.ioprio)
+      {
+        rv = IOPrio::set(opts_.ioprio);
+        if(rv < 0)
+          return AppError::runtime(-rv,"unable to set I/O priority");
+      }
+
+    if(opts_.rwtype == Options::SIM)
+      {
+        rv = sim.init(opts_.sim);
+        if(rv < 0)
+          return AppError::argument_invalid("invalid sim spec: " + opts_.sim);
+        BlkDev::simulate(&sim);
+      }
+
     switch(opts_.instruction)
       {
       case Options::INFO:
@@ -18,25 +18,41 @@
 
 #include "badblockfile.hpp"
 #include "blkdev.hpp"
+#include "blockranges.hpp"
+#include "bufferpool.hpp"
 #include "captcha.hpp"
 #include "errors.hpp"
 #include "info.hpp"
 #include "math.hpp"
 #include "options.hpp"
+#include "pattern.hpp"
+#include "ratelimiter.hpp"
 #include "signals.hpp"
 #include "time.hpp"
+#include "verify.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
 #include <errno.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
+#include <unistd.h>
 
-typedef std::vector<char> CharVec;
-typedef std::vector<CharVec> CharVecVec;
+typedef std::vector<Pattern> PatternVec;
 
 namespace l
 {
+  struct Miscompares
+  {
+    Miscompares() : blocks(0), bits(0) {}
+
+    uint64_t blocks;
+    uint64_t bits;
+  };
+
   static
   uint64_t
   trim_stepping(const BlkDev   &blkdev_,
@@ -55,99 +71,313 @@ namespace l
     return stepping_;
   }
 
+  static
+  void
+  append(std::vector<uint64_t> &badblocks_,
+         const BlockRanges     &bad_)
+  {
+    BlockRanges::const_iterator i;
+
+    for(i = bad_.begin(); i != bad_.end(); ++i)
+      for(uint64_t b = i->first; b < i->second; b++)
+        badblocks_.push_back(b);
+  }
+
+  /*
+    A chunk read back fine but didn't verify. Only the blocks which
+    differ are bad and only those have their flipped bits counted.
+  */
+  static
+  void
+  localise(const Pattern  &pattern_,
+           const uint64_t  block_,
+           const uint64_t  blocks_,
+           const uint64_t  lbs_,
+           const char     *buf_,
+           BlockRanges    &bad_,
+           Miscompares    &miscompares_)
+  {
+    uint64_t bits;
+
+    for(uint64_t i = 0; i < blocks_; i++)
+      {
+        if(pattern_.matches((block_ + i) * lbs_,&buf_[i * lbs_],lbs_))
+          continue;
+
+        bits = pattern_.flipped_bits((block_ + i) * lbs_,&buf_[i * lbs_],lbs_);
+        if(bits == 0)
+          continue;
+
+        bad_.add(block_ + i);
+        miscompares_.blocks++;
+        miscompares_.bits += bits;
+      }
+  }
+
+  /*
+    As above but against a copy of what was written.
+  */
+  static
+  void
+  localise(const char     *expected_,
+           const uint64_t  block_,
+           const uint64_t  blocks_,
+           const uint64_t  lbs_,
+           const char     *buf_,
+           BlockRanges    &bad_,
+           Miscompares    &miscompares_)
+  {
+    uint64_t bits;
+
+    for(uint64_t i = 0; i < blocks_; i++)
+      {
+        if(verify::equal(&expected_[i * lbs_],&buf_[i * lbs_],lbs_))
+          continue;
+
+        bits = verify::flipped_bits(&expected_[i * lbs_],&buf_[i * lbs_],lbs_);
+        if(bits == 0)
+          continue;
+
+        bad_.add(block_ + i);
+        miscompares_.blocks++;
+        miscompares_.bits += bits;
+      }
+  }
+
+  /*
+    The pattern is generated for just this chunk and the read back
+    compared against the buffer it was written from.
+  */
   static
   int
   write_read_compare(BlkDev         &blkdev_,
                      const uint64_t  stepping_,
                      const uint64_t  block_,
-                     CharVec        &tmpbuf_,
+                     char           *writebuf_,
+                     char           *tmpbuf_,
+                     const uint64_t  buflen_,
                      const int       retries_,
-                     const CharVec  &write_buf_)
+                     const Pattern  &pattern_,
+                     BlockRanges    &bad_,
+                     Miscompares    &miscompares_)
   {
     int rv;
+    const uint64_t lbs = blkdev_.logical_block_size();
 
-    rv = -1;
-    for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
-      rv = blkdev_.write(block_,stepping_,write_buf_);
-
-    if(rv < 0)
-      return rv;
+    pattern_.fill(block_ * lbs,writebuf_,stepping_ * lbs);
 
     rv = -1;
     for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
-      rv = blkdev_.read(block_,stepping_,tmpbuf_);
+      rv = blkdev_.write(block_,stepping_,writebuf_,buflen_);
+
+    if(rv >= 0)
+      {
+        rv = -1;
+        for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
+          rv = blkdev_.read(block_,stepping_,tmpbuf_,buflen_);
+      }
 
     if(rv < 0)
-      return rv;
+      {
+        bad_.add(block_,block_ + stepping_);
+        return rv;
+      }
 
-    rv = ::memcmp(&write_buf_[0],&tmpbuf_[0],tmpbuf_.size());
-    if(rv != 0)
-      return -EIO;
+    if(verify::equal(writebuf_,tmpbuf_,stepping_ * lbs))
+      return 0;
 
-    return 0;
+    l::localise(writebuf_,block_,stepping_,lbs,tmpbuf_,bad_,miscompares_);
+
+    return -EIO;
   }
 
+  /*
+    Every pattern is tried and the original data put back regardless
+    of earlier failures. Bad blocks are collected in bad_ and only an
+    invalid request is returned as an error.
+  */
   static
   int
-  burn_block(BlkDev            &blkdev_,
-             const uint64_t     stepping_,
-             const uint64_t     block_,
-             CharVec           &tmpbuf_,
-             CharVec           &savebuf_,
-             const uint64_t     retries_,
-             const CharVecVec  &patterns_)
+  burn_block(BlkDev           &blkdev_,
+             const uint64_t    stepping_,
+             const uint64_t    block_,
+             char             *writebuf_,
+             char             *tmpbuf_,
+             char             *savebuf_,
+             const uint64_t    buflen_,
+             const uint64_t    retries_,
+             const PatternVec &patterns_,
+             BlockRanges      &bad_,
+             Miscompares      &miscompares_)
   {
     int rv;
+    int err;
 
     rv = -1;
     for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
-      rv = blkdev_.read(block_,stepping_,savebuf_);
+      rv = blkdev_.read(block_,stepping_,savebuf_,buflen_);
 
     if(rv < 0)
-      ::memset(&savebuf_[0],0,savebuf_.size());
+      ::memset(savebuf_,0,buflen_);
 
+    err = 0;
     for(uint64_t i = 0; i < patterns_.size(); i++)
-      rv = l::write_read_compare(blkdev_,stepping_,block_,tmpbuf_,retries_,patterns_[i]);
+      {
+        rv = l::write_read_compare(blkdev_,stepping_,block_,writebuf_,tmpbuf_,buflen_,
+                                   retries_,patterns_[i],bad_,miscompares_);
+        if(rv == -EINVAL)
+          {
+            err = rv;
+            break;
+          }
+      }
 
     rv = -1;
     for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
-      rv = blkdev_.write(block_,stepping_,savebuf_);
+      rv = blkdev_.write(block_,stepping_,savebuf_,buflen_);
 
-    return rv;
+    if(rv == -EINVAL)
+      return rv;
+    if(rv < 0)
+      bad_.add(block_,block_ + stepping_);
+
+    return err;
   }
 
+  /*
+    Sequential write zones can only be written at the write pointer so
+    rather than burning each chunk in place the zone is reset, written
+    front to back with each pattern in turn and read back. What the
+    zone held can't be put back and it is left reset.
+  */
   static
   int
-  burnin_loop(BlkDev                &blkdev_,
-              const uint64_t         start_block_,
-              const uint64_t         end_block_,
-              const uint64_t         stepping_,
-              const uint64_t         buflen_,
-              std::vector<uint64_t> &badblocks_,
-              const uint64_t         max_errors_,
-              const int              retries_)
+  burn_zone(BlkDev             &blkdev_,
+            const BlkDev::Zone &zone_,
+            const uint64_t      stepping_,
+            char               *writebuf_,
+            char               *tmpbuf_,
+            const uint64_t      buflen_,
+            const uint64_t      retries_,
+            const PatternVec   &patterns_,
+            BlockRanges        &bad_,
+            Miscompares        &miscompares_)
   {
     int rv;
     uint64_t block;
+    uint64_t written;
     uint64_t stepping;
+    const uint64_t end = (zone_.start + zone_.capacity);
+    const uint64_t lbs = blkdev_.logical_block_size();
+
+    for(size_t p = 0; p < patterns_.size(); p++)
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        rv = blkdev_.reset_zone(zone_);
+        if(rv < 0)
+          return rv;
+
+        /*
+          A failed write leaves the write pointer somewhere unknown so
+          it isn't retried and the rest of the zone goes unwritten.
+        */
+        rv = 0;
+        stepping = 0;
+        for(block = zone_.start; block < end; block += stepping)
+          {
+            stepping = std::min(stepping_,end - block);
+            patterns_[p].fill(block * lbs,writebuf_,stepping * lbs);
+            rv = blkdev_.write(block,stepping,writebuf_,buflen_);
+            if(rv < 0)
+              break;
+          }
+
+        written = block;
+        if(rv == -EINVAL)
+          return rv;
+        if(rv < 0)
+          bad_.add(block,block + stepping);
+
+        for(block = zone_.start; block < written; block += stepping)
+          {
+            stepping = std::min(stepping_,written - block);
+
+            rv = -1;
+            for(uint64_t i = 0; ((i <= retries_) && (rv < 0)); i++)
+              rv = blkdev_.read(block,stepping,tmpbuf_,buflen_);
+
+            if(rv < 0)
+              bad_.add(block,block + stepping);
+            else if(!patterns_[p].matches(block * lbs,tmpbuf_,stepping * lbs))
+              l::localise(patterns_[p],block,stepping,lbs,tmpbuf_,bad_,miscompares_);
+          }
+      }
+
+    return blkdev_.reset_zone(zone_);
+  }
+
+  /*
+    Sequential zones are burned whole so a range which begins or ends
+    part way through one would destroy data outside of it.
+  */
+  static
+  bool
+  splits_sequential_zone(const std::vector<BlkDev::Zone> &zones_,
+                         const uint64_t                   block_)
+  {
+    for(size_t i = 0; i < zones_.size(); i++)
+      {
+        const BlkDev::Zone &z = zones_[i];
+
+        if(!z.sequential())
+          continue;
+        if((z.start < block_) && (block_ < (z.start + z.len)))
+          return true;
+      }
+
+    return false;
+  }
+
+  static
+  int
+  burnin_loop(BlkDev                          &blkdev_,
+              const uint64_t                   start_block_,
+              const uint64_t                   end_block_,
+              const uint64_t                   stepping_,
+              const uint64_t                   buflen_,
+              std::vector<uint64_t>           &badblocks_,
+              const uint64_t                   max_errors_,
+              const int                        retries_,
+              const PatternVec                &patterns_,
+              const std::vector<BlkDev::Zone> &zones_,
+              Miscompares                     &miscompares_)
+  {
+    int rv;
+    size_t zone;
+    uint64_t block;
+    uint64_t stepping;
+    char *tmpbuf;
+    char *savebuf;
+    char *writebuf;
+    BufferPool pool;
     InfoPrinter info;
-    CharVec tmpbuf;
-    CharVec savebuf;
-    CharVecVec patterns;
     const double start_time = Time::get_monotonic();
 
-    tmpbuf.resize(buflen_,0x00);
-    savebuf.resize(buflen_,0x00);
+    rv = pool.init(buflen_,3);
+    if(rv < 0)
+      return rv;
 
-    patterns.resize(4);
-    patterns[0].resize(buflen_,0x00);
-    patterns[1].resize(buflen_,0x55);
-    patterns[2].resize(buflen_,0xAA);
-    patterns[3].resize(buflen_,0xFF);
+    tmpbuf   = pool.get();
+    savebuf  = pool.get();
+    writebuf = pool.get();
 
     info.init(start_block_,end_block_,&badblocks_);
     info.print(start_block_);
 
+    rv    = 0;
+    zone  = 0;
     block = start_block_;
     while(block < end_block_)
       {
@@ -162,18 +392,53 @@ namespace l
 
         stepping = l::trim_stepping(blkdev_,block,stepping_);
 
-        rv = l::burn_block(blkdev_,stepping,block,tmpbuf,savebuf,retries_,patterns);
+        while((zone < zones_.size()) &&
+              ((zones_[zone].start + zones_[zone].len) <= block))
+          zone++;
+        if(zone < zones_.size())
+          {
+            const BlkDev::Zone &z = zones_[zone];
+
+            if(!z.writable())
+              {
+                block = (z.start + z.len);
+                continue;
+              }
+
+            if(z.sequential())
+              {
+                BlockRanges bad;
+
+                rv = l::burn_zone(blkdev_,z,stepping_,writebuf,tmpbuf,buflen_,
+                                  retries_,patterns_,bad,miscompares_);
+                if(rv < 0)
+                  break;
+
+                block = (z.start + z.len);
+                l::append(badblocks_,bad);
+
+                if(badblocks_.size() > max_errors_)
+                  break;
+                continue;
+              }
+
+            stepping = std::min(stepping,(z.start + z.len) - block);
+          }
+
+        BlockRanges bad;
+
+        rv = l::burn_block(blkdev_,stepping,block,writebuf,tmpbuf,savebuf,buflen_,
+                           retries_,patterns_,bad,miscompares_);
+        if(rv < 0)
+          break;
 
         block += stepping;
-        if(rv >= 0)
+        if(bad.empty())
           continue;
-        if(rv == -EINVAL)
-          break;
 
         info.print(block);
 
-        for(uint64_t i = 0; i < stepping; i++)
-          badblocks_.push_back(block+i);
+        l::append(badblocks_,bad);
 
         if(badblocks_.size() > max_errors_)
           break;
@@ -184,6 +449,627 @@ namespace l
     return rv;
   }
 
+  /*
+    Shared between the threads of a threaded burnin. Bad blocks are
+    appended to the burnin's list under the mutex.
+  */
+  struct BurninStatus
+  {
+    pthread_mutex_t        mutex;
+    std::vector<uint64_t> *badblocks;
+    uint64_t               processed;
+    uint64_t               lastbad;
+    uint64_t               max_errors;
+    uint64_t               finished;
+    bool                   stop;
+  };
+
+  struct BurninWorker
+  {
+    pthread_t           thread;
+    BlkDev              blkdev;
+    char               *tmpbuf;
+    char               *savebuf;
+    char               *writebuf;
+    uint64_t            buflen;
+    uint64_t            stepping;
+    uint64_t            block;
+    uint64_t            end_block;
+    uint64_t            stride;
+    int                 retries;
+    const PatternVec   *patterns;
+    Miscompares         miscompares;
+    BurninStatus       *status;
+    int                 rv;
+  };
+
+  /*
+    Each worker burns every `stride`th chunk from its own offset with
+    its own device handle. A chunk is only ever touched by the one
+    worker which saves, tests, and restores it start to finish exactly
+    as the single threaded loop does so chunks being in different
+    phases at once doesn't put the original data at risk. Workers only
+    stop between chunks.
+  */
+  static
+  void*
+  burnin_worker(void *data_)
+  {
+    int rv;
+    bool stop;
+    uint64_t stepping;
+    BurninWorker *w = (BurninWorker*)data_;
+    BurninStatus *s = w->status;
+    const uint64_t stride = (w->stepping * w->stride);
+
+    rv   = 0;
+    stop = false;
+    while(!stop && (w->block < w->end_block))
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        BlockRanges bad;
+
+        stepping = l::trim_stepping(w->blkdev,w->block,w->stepping);
+        stepping = std::min(stepping,w->end_block - w->block);
+
+        rv = l::burn_block(w->blkdev,stepping,w->block,w->writebuf,w->tmpbuf,w->savebuf,
+                           w->buflen,w->retries,*w->patterns,bad,w->miscompares);
+        if(rv < 0)
+          break;
+
+        pthread_mutex_lock(&s->mutex);
+        w->block     += stride;
+        s->processed += stepping;
+        l::append(*s->badblocks,bad);
+        if(!bad.empty())
+          s->lastbad = std::max(s->lastbad,s->badblocks->back());
+        if(s->badblocks->size() > s->max_errors)
+          s->stop = true;
+        stop = s->stop;
+        pthread_mutex_unlock(&s->mutex);
+      }
+
+    pthread_mutex_lock(&s->mutex);
+    w->rv = rv;
+    s->finished++;
+    pthread_mutex_unlock(&s->mutex);
+
+    return NULL;
+  }
+
+  static
+  uint64_t
+  lowest_worker_block(const std::vector<BurninWorker*> &workers_,
+                      const uint64_t                    end_block_)
+  {
+    uint64_t rv;
+
+    rv = end_block_;
+    for(size_t i = 0; i < workers_.size(); i++)
+      rv = std::min(rv,workers_[i]->block);
+
+    return rv;
+  }
+
+  static
+  int
+  spawn_thread(pthread_t  *thread_,
+               void*     (*func_)(void*),
+               void       *data_)
+  {
+    int rv;
+    sigset_t sigset_old;
+    sigset_t sigset_new;
+
+    sigfillset(&sigset_new);
+    pthread_sigmask(SIG_SETMASK,&sigset_new,&sigset_old);
+
+    rv = pthread_create(thread_,NULL,func_,data_);
+
+    pthread_sigmask(SIG_SETMASK,&sigset_old,NULL);
+
+    return -rv;
+  }
+
+  static
+  void
+  set_blkdev_rwtype(BlkDev                &blkdev_,
+                    const Options::RWType  rwtype_)
+  {
+    switch(rwtype_)
+      {
+      case Options::ATA:
+        blkdev_.set_rw_ata();
+        break;
+      case Options::ATA_PIO:
+        blkdev_.set_rw_ata_pio();
+        break;
+      case Options::SCSI:
+        blkdev_.set_rw_scsi();
+        break;
+      case Options::SCSI_VERIFY:
+        blkdev_.set_rw_scsi_verify();
+        break;
+      case Options::OS:
+        blkdev_.set_rw_os();
+        break;
+      case Options::VERIFY:
+        blkdev_.set_rw_verify();
+        break;
+      case Options::SIM:
+        blkdev_.set_rw_sim();
+        break;
+      }
+  }
+
+  /*
+    The device is held open exclusively by the main thread so the
+    workers open it without O_EXCL.
+  */
+  static
+  int
+  burnin_threaded(BlkDev                &blkdev_,
+                  const Options         &opts_,
+                  const uint64_t         start_block_,
+                  const uint64_t         end_block_,
+                  const uint64_t         stepping_,
+                  const uint64_t         buflen_,
+                  std::vector<uint64_t> &badblocks_,
+                  const PatternVec      &patterns_,
+                  Miscompares           &miscompares_)
+  {
+    int rv;
+    uint64_t spawned;
+    BufferPool pool;
+    InfoPrinter info;
+    BurninStatus status;
+    std::vector<BurninWorker*> workers;
+    const size_t first_new = badblocks_.size();
+
+    rv = pool.init(buflen_,opts_.threads * 3);
+    if(rv < 0)
+      return rv;
+
+    status.mutex      = PTHREAD_MUTEX_INITIALIZER;
+    status.badblocks  = &badblocks_;
+    status.processed  = 0;
+    status.lastbad    = 0;
+    status.max_errors = opts_.max_errors;
+    status.finished   = 0;
+    status.stop       = false;
+
+    for(uint64_t i = 0; i < opts_.threads; i++)
+      {
+        BurninWorker *w = new BurninWorker();
+
+        w->tmpbuf    = pool.get();
+        w->savebuf   = pool.get();
+        w->writebuf  = pool.get();
+        w->buflen    = buflen_;
+        w->stepping  = stepping_;
+        w->block     = (start_block_ + (i * stepping_));
+        w->end_block = end_block_;
+        w->stride    = opts_.threads;
+        w->retries   = opts_.retries;
+        w->patterns  = &patterns_;
+        w->status    = &status;
+        w->rv        = 0;
+        workers.push_back(w);
+
+        rv = w->blkdev.open_rdwr(opts_.device,false);
+        if(rv < 0)
+          goto cleanup;
+        l::set_blkdev_rwtype(w->blkdev,opts_.rwtype);
+        w->blkdev.set_rate_limiter(blkdev_.rate_limiter());
+        w->blkdev.set_fua(blkdev_.fua());
+        if(opts_.direct || opts_.fua)
+          {
+            rv = w->blkdev.set_direct_io(true);
+            if(rv < 0)
+              goto cleanup;
+          }
+      }
+
+    info.init(start_block_,end_block_,&badblocks_);
+    info.print(start_block_);
+
+    rv = 0;
+    spawned = 0;
+    for(; spawned < workers.size(); spawned++)
+      {
+        rv = l::spawn_thread(&workers[spawned]->thread,
+                             l::burnin_worker,
+                             workers[spawned]);
+        if(rv < 0)
+          break;
+      }
+
+    while(true)
+      {
+        bool finished;
+
+        pthread_mutex_lock(&status.mutex);
+        if(signals::signaled_to_exit() || (rv < 0))
+          status.stop = true;
+        finished = (status.finished == spawned);
+        if(finished || signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            info.print(l::lowest_worker_block(workers,end_block_),
+                       status.processed,
+                       badblocks_.size(),
+                       status.lastbad);
+          }
+        pthread_mutex_unlock(&status.mutex);
+
+        if(finished)
+          break;
+
+        ::usleep(100 * 1000);
+      }
+
+    for(uint64_t i = 0; i < spawned; i++)
+      {
+        pthread_join(workers[i]->thread,NULL);
+        if((rv == 0) && (workers[i]->rv < 0))
+          rv = workers[i]->rv;
+        miscompares_.blocks += workers[i]->miscompares.blocks;
+        miscompares_.bits   += workers[i]->miscompares.bits;
+      }
+
+    std::sort(badblocks_.begin() + first_new,badblocks_.end());
+
+  cleanup:
+    for(size_t i = 0; i < workers.size(); i++)
+      delete workers[i];
+
+    return rv;
+  }
+
+  struct StreamSlot
+  {
+    uint64_t  block;
+    uint64_t  stepping;
+    char     *buf;
+    bool      busy;
+  };
+
+  struct StreamContext
+  {
+    BlkDev                  *blkdev;
+    uint64_t                 start_block;
+    uint64_t                 end_block;
+    uint64_t                 stepping;
+    uint64_t                 buflen;
+    uint64_t                 max_errors;
+    uint64_t                 flush_blocks;
+    int                      retries;
+    bool                     aio;
+    const Pattern           *pattern;
+    std::vector<StreamSlot>  slots;
+    BlockRanges              bad;
+    std::vector<uint64_t>   *badblocks;
+    Miscompares             *miscompares;
+  };
+
+  /*
+    A block failing every pass is only listed once.
+  */
+  static
+  void
+  add_bad(StreamContext  &ctx_,
+          const uint64_t  block_)
+  {
+    if(ctx_.bad.contains(block_))
+      return;
+
+    ctx_.bad.add(block_);
+    ctx_.badblocks->push_back(block_);
+  }
+
+  static
+  void
+  add_bad(StreamContext     &ctx_,
+          const BlockRanges &bad_)
+  {
+    BlockRanges::const_iterator i;
+
+    for(i = bad_.begin(); i != bad_.end(); ++i)
+      for(uint64_t b = i->first; b < i->second; b++)
+        l::add_bad(ctx_,b);
+  }
+
+  /*
+    A chunk failed to write, read, or verify. Redo it a block at a time
+    to find which blocks are bad.
+  */
+  static
+  void
+  check_blocks(StreamContext    &ctx_,
+               const StreamSlot &slot_,
+               const bool        write_)
+  {
+    int64_t rv;
+    BlkDev &blkdev = *ctx_.blkdev;
+    const uint64_t lbs = blkdev.logical_block_size();
+
+    for(uint64_t b = slot_.block; b < (slot_.block + slot_.stepping); b++)
+      {
+        if(write_)
+          ctx_.pattern->fill(b * lbs,slot_.buf,lbs);
+
+        rv = -1;
+        for(int i = 0; ((i <= ctx_.retries) && (rv <= 0)); i++)
+          rv = (write_ ?
+                blkdev.write(b,1,slot_.buf,lbs) :
+                blkdev.read(b,1,slot_.buf,lbs));
+
+        if((rv <= 0) || (!write_ && !ctx_.pattern->matches(b * lbs,slot_.buf,lbs)))
+          l::add_bad(ctx_,b);
+      }
+  }
+
+  static
+  uint64_t
+  lowest_inflight(const std::vector<StreamSlot> &slots_,
+                  const uint64_t                 block_)
+  {
+    uint64_t rv;
+
+    rv = block_;
+    for(size_t i = 0; i < slots_.size(); i++)
+      if(slots_[i].busy)
+        rv = std::min(rv,slots_[i].block);
+
+    return rv;
+  }
+
+  /*
+    Write the pattern across the whole range, or read it all back and
+    verify, keeping up to a slot's worth of requests in flight. Without
+    io_uring there's a single slot and the request is issued
+    synchronously when it would otherwise be waited on.
+
+    Unless written FUA the writes are flushed from the drive's cache
+    once the pass is done so the verify reads the media. With a flush
+    interval new writes stop every `flush_blocks` until those in
+    flight complete and are flushed, one flush per interval rather
+    than per request.
+  */
+  static
+  int
+  stream_pass(StreamContext &ctx_,
+              InfoPrinter   &info_,
+              const bool     write_)
+  {
+    int rv;
+    int err;
+    bool done;
+    uint64_t tag;
+    uint64_t block;
+    uint64_t flushed;
+    uint64_t inflight;
+    int64_t  blocks;
+    BlkDev &blkdev = *ctx_.blkdev;
+    const uint64_t lbs = blkdev.logical_block_size();
+
+    err      = 0;
+    done     = false;
+    inflight = 0;
+    block    = ctx_.start_block;
+    flushed  = block;
+    while(true)
+      {
+        if(signals::signaled_to_exit())
+          done = true;
+
+        if(signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            info_.print(l::lowest_inflight(ctx_.slots,block));
+          }
+
+        for(size_t i = 0; !done && (i < ctx_.slots.size()) && (block < ctx_.end_block); i++)
+          {
+            StreamSlot &slot = ctx_.slots[i];
+
+            if(write_ && ctx_.flush_blocks && ((block - flushed) >= ctx_.flush_blocks))
+              break;
+            if(slot.busy)
+              continue;
+
+            slot.block    = block;
+            slot.stepping = std::min(ctx_.stepping,ctx_.end_block - block);
+            if(write_)
+              ctx_.pattern->fill(slot.block * lbs,slot.buf,slot.stepping * lbs);
+            if(ctx_.aio)
+              {
+                rv = (write_ ?
+                      blkdev.aio_write(slot.block,slot.stepping,slot.buf,ctx_.buflen,i) :
+                      blkdev.aio_read(slot.block,slot.stepping,slot.buf,ctx_.buflen,i));
+                if(rv < 0)
+                  break;
+              }
+
+            slot.busy = true;
+            block    += slot.stepping;
+            inflight++;
+          }
+
+        if(write_ && !blkdev.fua() && !done && (inflight == 0) && (block > flushed))
+          {
+            rv = blkdev.sync();
+            if(rv < 0)
+              {
+                err = rv;
+                break;
+              }
+
+            flushed = block;
+            continue;
+          }
+
+        if(inflight == 0)
+          break;
+
+        if(ctx_.aio)
+          {
+            rv = blkdev.aio_submit();
+            if((rv < 0) && (rv != -EINTR) && (rv != -EAGAIN))
+              {
+                err  = rv;
+                done = true;
+              }
+
+            rv = blkdev.aio_wait(&tag,&blocks);
+            if(rv == -EINTR)
+              continue;
+            if(rv < 0)
+              {
+                err = rv;
+                break;
+              }
+          }
+        else
+          {
+            StreamSlot &slot = ctx_.slots[0];
+
+            tag    = 0;
+            blocks = (write_ ?
+                      blkdev.write(slot.block,slot.stepping,slot.buf,ctx_.buflen) :
+                      blkdev.read(slot.block,slot.stepping,slot.buf,ctx_.buflen));
+          }
+
+        StreamSlot &slot = ctx_.slots[tag];
+
+        inflight--;
+        slot.busy = false;
+
+        if(blocks == -EINVAL)
+          {
+            err  = blocks;
+            done = true;
+          }
+        else if(blocks < (int64_t)slot.stepping)
+          {
+            info_.print(slot.block);
+
+            l::check_blocks(ctx_,slot,write_);
+
+            if(ctx_.badblocks->size() > ctx_.max_errors)
+              done = true;
+          }
+        else if(!write_ && !ctx_.pattern->matches(slot.block * lbs,slot.buf,slot.stepping * lbs))
+          {
+            BlockRanges bad;
+
+            info_.print(slot.block);
+
+            l::localise(*ctx_.pattern,slot.block,slot.stepping,lbs,slot.buf,bad,*ctx_.miscompares);
+            l::add_bad(ctx_,bad);
+
+            if(ctx_.badblocks->size() > ctx_.max_errors)
+              done = true;
+          }
+      }
+
+    info_.print(std::min(block,ctx_.end_block));
+
+    return err;
+  }
+
+  /*
+    Destructive: each pattern is written across the entire range and
+    then the entire range read back and verified so the drive sees long
+    sequential transfers rather than a short write and read of every
+    chunk.
+  */
+  static
+  int
+  burnin_streaming(BlkDev                &blkdev_,
+                   const uint64_t         start_block_,
+                   const uint64_t         end_block_,
+                   const uint64_t         stepping_,
+                   const uint64_t         buflen_,
+                   const uint64_t         queue_depth_,
+                   std::vector<uint64_t> &badblocks_,
+                   const uint64_t         max_errors_,
+                   const int              retries_,
+                   const uint64_t         flush_blocks_,
+                   const PatternVec      &patterns_,
+                   Miscompares           &miscompares_)
+  {
+    int rv;
+    BufferPool pool;
+    InfoPrinter info;
+    StreamContext ctx;
+
+    ctx.aio = false;
+    if(queue_depth_ > 1)
+      {
+        rv = blkdev_.aio_init(queue_depth_);
+        if(rv < 0)
+          std::cout << "io_uring unavailable ("
+                    << Error::to_string(-rv)
+                    << "): using synchronous reads and writes"
+                    << std::endl;
+        ctx.aio = (rv >= 0);
+      }
+
+    ctx.slots.resize(ctx.aio ? queue_depth_ : 1);
+    rv = pool.init(buflen_,ctx.slots.size());
+    if(rv < 0)
+      return rv;
+
+    for(size_t i = 0; i < ctx.slots.size(); i++)
+      {
+        ctx.slots[i].buf  = pool.get();
+        ctx.slots[i].busy = false;
+      }
+
+    ctx.blkdev       = &blkdev_;
+    ctx.start_block  = start_block_;
+    ctx.end_block    = end_block_;
+    ctx.stepping     = stepping_;
+    ctx.buflen       = buflen_;
+    ctx.max_errors   = max_errors_;
+    ctx.retries      = retries_;
+    ctx.flush_blocks = flush_blocks_;
+    ctx.badblocks    = &badblocks_;
+    ctx.miscompares  = &miscompares_;
+    ctx.bad.add(badblocks_);
+
+    rv = 0;
+    for(size_t p = 0; p < patterns_.size(); p++)
+      {
+        ctx.pattern = &patterns_[p];
+
+        for(int w = 1; w >= 0; w--)
+          {
+            if(signals::signaled_to_exit() ||
+               (badblocks_.size() > max_errors_))
+              return rv;
+
+            std::cout << "\r\x1B[2KPattern "
+                      << patterns_[p].name()
+                      << " (" << (p + 1) << "/" << patterns_.size() << "): "
+                      << (w ? "writing" : "verifying")
+                      << std::endl;
+
+            info.init(start_block_,end_block_,&badblocks_);
+            info.print(start_block_);
+
+            rv = l::stream_pass(ctx,info,(w == 1));
+            if(rv < 0)
+              return rv;
+          }
+      }
+
+    return rv;
+  }
+
   static
   AppError
   burnin(BlkDev                &blkdev_,
@@ -196,6 +1082,10 @@ namespace l
     uint64_t  start_block;
     uint64_t  end_block;
     uint64_t  stepping;
+    uint64_t  flush_blocks;
+    PatternVec patterns;
+    l::Miscompares miscompares;
+    std::vector<BlkDev::Zone> zones;
 
     retries     = opts_.retries;
     stepping    = ((opts_.stepping == 0) ?
@@ -206,6 +1096,27 @@ namespace l
     end_block   = std::min(opts_.end_block,blkdev_.logical_block_count());
     end_block   = math::round_up(end_block,stepping);
     end_block   = std::min(end_block,blkdev_.logical_block_count());
+    if(opts_.streaming && (opts_.stepping == 0))
+      {
+        stepping = math::round_down(blkdev_.max_transfer_blocks(),stepping);
+        buflen   = (stepping * blkdev_.logical_block_size());
+      }
+
+    flush_blocks = ((opts_.flush_interval * 1000000) / blkdev_.logical_block_size());
+    patterns     = Pattern::defaults();
+    if(!opts_.patterns.empty())
+      Pattern::parse(opts_.patterns,&patterns);
+
+    rv = blkdev_.report_zones(zones);
+    if(rv < 0)
+      return AppError::runtime(-rv,"unable to report zones");
+    if(opts_.streaming && blkdev_.zoned())
+      return AppError::argument_invalid("streaming burnin isn't supported on zoned devices");
+    if((opts_.threads > 1) && blkdev_.zoned())
+      return AppError::argument_invalid("threaded burnin isn't supported on zoned devices");
+    if(l::splits_sequential_zone(zones,start_block) ||
+       l::splits_sequential_zone(zones,end_block))
+      return AppError::argument_invalid("start and end block can not fall within a sequential zone");
 
     std::cout << "start block: "
               << start_block << std::endl
@@ -220,7 +1131,30 @@ namespace l
               << "r/w size: "
               << stepping << " blocks / "
               << buflen << " bytes"
-              << std::endl;
+              << std::endl
+              << "patterns:";
+    for(size_t i = 0; i < patterns.size(); i++)
+      std::cout << (i ? "," : " ") << patterns[i].name();
+    std::cout << std::endl;
+    if(opts_.fua)
+      std::cout << "fua: on" << std::endl;
+    if(opts_.streaming)
+      std::cout << "mode: streaming (destructive)" << std::endl
+                << "queue depth: "
+                << opts_.queue_depth << std::endl;
+    if(opts_.threads > 1)
+      std::cout << "threads: "
+                << opts_.threads << std::endl;
+    if(flush_blocks)
+      std::cout << "flush interval: "
+                << opts_.flush_interval << "MB" << std::endl;
+    if(blkdev_.zoned())
+      std::cout << "zones: "
+                << zones.size()
+                << " of "
+                << blkdev_.zone_blocks()
+                << " blocks (sequential zones are burned whole and left reset)"
+                << std::endl;
 
     signals::alarm(1);
 
@@ -230,39 +1164,60 @@ namespace l
               << end_block
               << std::endl;
 
-    rv = l::burnin_loop(blkdev_,
-                        start_block,
-                        end_block,
-                        stepping,
-                        buflen,
-                        badblocks_,
-                        opts_.max_errors,
-                        retries);
+    if(opts_.streaming)
+      rv = l::burnin_streaming(blkdev_,
+                               start_block,
+                               end_block,
+                               stepping,
+                               buflen,
+                               opts_.queue_depth,
+                               badblocks_,
+                               opts_.max_errors,
+                               retries,
+                               flush_blocks,
+                               patterns,
+                               miscompares);
+    else if(opts_.threads > 1)
+      rv = l::burnin_threaded(blkdev_,
+                              opts_,
+                              start_block,
+                              end_block,
+                              stepping,
+                              buflen,
+                              badblocks_,
+                              patterns,
+                              miscompares);
+    else
+      rv = l::burnin_loop(blkdev_,
+                          start_block,
+                          end_block,
+                          stepping,
+                          buflen,
+                          badblocks_,
+                          opts_.max_errors,
+                          retries,
+                          patterns,
+                          zones,
+                          miscompares);
 
     std::cout << std::endl;
 
+    if(miscompares.blocks)
+      std::cout << "miscompares: "
+                << miscompares.blocks
+                << " blocks, "
+                << miscompares.bits
+                << " bits flipped ("
+                << ((double)miscompares.bits / miscompares.blocks)
+                << " per block)"
+                << std::endl;
+
     if(rv < 0)
       return AppError::runtime(-rv,"error when performing burnin");
 
     return AppError::success();
   }
 
-  static
-  void
-  set_blkdev_rwtype(BlkDev                &blkdev_,
-                    const Options::RWType  rwtype_)
-  {
-    switch(rwtype_)
-      {
-      case Options::ATA:
-        blkdev_.set_rw_ata();
-        break;
-      case Options::OS:
-        blkdev_.set_rw_os();
-        break;
-      }
-  }
-
   static
   AppError
   burnin(const Options &opts_)
@@ -270,6 +1225,7 @@ namespace l
     int rv;
     AppError err;
     BlkDev blkdev;
+    RateLimiter limiter;
     std::string captcha;
     std::string input_file;
     std::string output_file;
@@ -300,6 +1256,23 @@ namespace l
 
     l::set_blkdev_rwtype(blkdev,opts_.rwtype);
 
+    /*
+      Buffered writes to sequential zones can reach the device out of
+      order. A streaming burnin would only churn the page cache and
+      FUA is pointless if the read back comes from it.
+    */
+    blkdev.set_fua(opts_.fua);
+    if(opts_.direct || opts_.streaming || opts_.fua || blkdev.zoned())
+      {
+        rv = blkdev.set_direct_io(true);
+        if(rv < 0)
+          return AppError::opening_device(-rv,opts_.device);
+      }
+
+    limiter.set(opts_.max_rate * 1000000,opts_.max_iops);
+    if(limiter.enabled())
+      blkdev.set_rate_limiter(&limiter);
+
     err = l::burnin(blkdev,opts_,badblocks);
 
     rv = BadBlockFile::write(output_file,badblocks);
@@ -18,9 +18,11 @@
 
 #include "badblockfile.hpp"
 #include "blkdev.hpp"
+#include "bufferpool.hpp"
 #include "captcha.hpp"
 #include "errors.hpp"
 #include "options.hpp"
+#include "ratelimiter.hpp"
 #include "signals.hpp"
 
 #include <iostream>
@@ -85,9 +87,13 @@ namespace l
     int rv;
     char *buf;
     uint64_t buflen;
+    BufferPool pool;
 
     buflen = blkdev_.logical_block_size();
-    buf    = new char[buflen];
+    rv = pool.init(buflen,1);
+    if(rv < 0)
+      return rv;
+    buf = pool.get();
 
     for(uint64_t i = 0, ei = badblocks_.size(); i != ei; ++i)
       {
@@ -96,7 +102,7 @@ namespace l
           break;
       }
 
-    delete[] buf;
+    pool.put(buf);
 
     return rv;
   }
@@ -111,9 +117,24 @@ namespace l
       case Options::ATA:
         blkdev.set_rw_ata();
         break;
+      case Options::ATA_PIO:
+        blkdev.set_rw_ata_pio();
+        break;
+      case Options::SCSI:
+        blkdev.set_rw_scsi();
+        break;
+      case Options::SCSI_VERIFY:
+        blkdev.set_rw_scsi_verify();
+        break;
       case Options::OS:
         blkdev.set_rw_os();
         break;
+      case Options::VERIFY:
+        blkdev.set_rw_verify();
+        break;
+      case Options::SIM:
+        blkdev.set_rw_sim();
+        break;
       }
   }
 
@@ -123,6 +144,7 @@ namespace l
   {
     int rv;
     BlkDev blkdev;
+    RateLimiter limiter;
     std::string input_file;
     std::vector<uint64_t> badblocks;
 
@@ -133,6 +155,17 @@ namespace l
       return AppError::opening_device(-rv,opts_.device);
     l::set_blkdev_rwtype(blkdev,opts_.rwtype);
 
+    if(opts_.direct)
+      {
+        rv = blkdev.set_direct_io(true);
+        if(rv < 0)
+          return AppError::opening_device(-rv,opts_.device);
+      }
+
+    limiter.set(opts_.max_rate * 1000000,opts_.max_iops);
+    if(limiter.enabled())
+      blkdev.set_rate_limiter(&limiter);
+
     const std::string captcha = captcha::calculate(blkdev);
     if(opts_.captcha != captcha)
       return AppError::captcha(opts_.captcha,captcha);
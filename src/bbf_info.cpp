@@ -57,6 +57,8 @@ namespace bbf
   {
     int rv;
     BlkDev blkdev;
+    uint16_t erc_read;
+    uint16_t erc_write;
     sg::identity ident;
 
     rv = blkdev.open_read(opts_.device);
@@ -94,7 +96,14 @@ namespace bbf
           << "   - supports_sata_gen2: "       << ident.supports_sata_gen2 << std::endl
           << "   - supports_sata_gen3: "       << ident.supports_sata_gen3 << std::endl
           << "   - trim_supported: "          << ident.trim_supported << std::endl
+          << "   - sct_erc_supported: "       << ident.sct_erc_supported << std::endl
           ;
+
+        if(ident.sct_erc_supported && (blkdev.erc_get(&erc_read,&erc_write) == 0))
+          std::cout
+            << " - error_recovery_control:" << std::endl
+            << "   - read: "  << (erc_read / 10.0) << "s" << std::endl
+            << "   - write: " << (erc_write / 10.0) << "s" << std::endl;
       }
 
     std::cout
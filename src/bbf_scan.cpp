@@ -18,19 +18,35 @@
 
 #include "badblockfile.hpp"
 #include "blkdev.hpp"
+#include "blockranges.hpp"
+#include "blocktofilemapper.hpp"
+#include "bufferpool.hpp"
+#include "captcha.hpp"
+#include "checkpoint.hpp"
 #include "errors.hpp"
+#include "filetoblkdev.hpp"
+#include "histogram.hpp"
 #include "info.hpp"
 #include "math.hpp"
 #include "options.hpp"
+#include "ratelimiter.hpp"
+#include "rnd.hpp"
 #include "signals.hpp"
 #include "time.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <utility>
+#include <vector>
 
 #include <errno.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 namespace l
@@ -53,128 +69,1916 @@ namespace l
     return stepping_;
   }
 
+  static
+  void
+  set_blkdev_rwtype(BlkDev                &blkdev,
+                    const Options::RWType  rwtype)
+  {
+    switch(rwtype)
+      {
+      case Options::ATA:
+        blkdev.set_rw_ata();
+        break;
+      case Options::ATA_PIO:
+        blkdev.set_rw_ata_pio();
+        break;
+      case Options::OS:
+        blkdev.set_rw_os();
+        break;
+      case Options::VERIFY:
+        blkdev.set_rw_verify();
+        break;
+      case Options::SCSI:
+        blkdev.set_rw_scsi();
+        break;
+      case Options::SCSI_VERIFY:
+        blkdev.set_rw_scsi_verify();
+        break;
+      case Options::SIM:
+        blkdev.set_rw_sim();
+        break;
+      }
+  }
+
+  /*
+    Regular files have no logical block size of their own.
+  */
+  static
+  uint64_t
+  file_block_size(const Options &opts_)
+  {
+    return ((opts_.block_size == 0) ? 512 : opts_.block_size);
+  }
+
+  /*
+    State of a single device's scan. Shared between whichever thread(s)
+    are doing the reading and whoever is printing the progress.
+  */
+  struct ScanStatus
+  {
+    pthread_mutex_t mutex;
+    double          start_time;
+    uint64_t        start_block;
+    uint64_t        end_block;
+    uint64_t        current;
+    uint64_t        processed;
+    uint64_t        badcount;
+    uint64_t        lastbad;
+    uint64_t        finished;
+    bool            stop;
+    bool            done;
+  };
+
+  struct ScanLatency
+  {
+    Histogram              histogram;
+    std::vector<SlowBlock> slowblocks;
+    uint64_t               slow_usec;
+  };
+
+  struct BlockRange
+  {
+    uint64_t start;
+    uint64_t end;
+  };
+
+  struct AIOSlot
+  {
+    uint64_t  block;
+    uint64_t  stepping;
+    double    start_time;
+    char     *buf;
+    bool      busy;
+  };
+
+  struct ScanContext
+  {
+    BlkDev                        *blkdev;
+    std::string                    device;
+    const Options                 *opts;
+    uint64_t                       stepping;
+    uint64_t                       max_stepping;
+    uint64_t                       start_block;
+    uint64_t                       end_block;
+    uint64_t                       buflen;
+    std::vector<uint64_t>         *badblocks;
+    const BlockRanges             *known;
+    const BlockRanges             *include;
+    uint64_t                       skipped;
+    uint64_t                       processed_base;
+    ScanLatency                   *latency;
+    ScanStatus                    *status;
+    InfoPrinter                   *info;
+    ScanCheckpoint                *checkpoint;
+    std::string                    checkpoint_file;
+    double                         checkpoint_time;
+    double                         elapsed;
+    const std::vector<BlockRange> *deferred;
+    const std::vector<AIOSlot>    *slots;
+    const BlockRanges             *resumed;
+    BlockRanges                    done;
+  };
+
+  static
+  void
+  init_status(ScanStatus &status_)
+  {
+    status_.mutex       = PTHREAD_MUTEX_INITIALIZER;
+    status_.start_time  = Time::get_monotonic();
+    status_.start_block = 0;
+    status_.end_block   = 0;
+    status_.current     = 0;
+    status_.processed   = 0;
+    status_.badcount    = 0;
+    status_.lastbad     = 0;
+    status_.finished    = 0;
+    status_.stop        = false;
+    status_.done        = false;
+  }
+
+  static
+  int
+  write_checkpoint(ScanContext                 &ctx_,
+                   const uint64_t               current_,
+                   const std::vector<uint64_t> &badblocks_)
+  {
+    ScanCheckpoint &c = *ctx_.checkpoint;
+
+    c.current_block = current_;
+    c.elapsed       = (ctx_.elapsed + (Time::get_monotonic() - ctx_.status->start_time));
+    c.badblocks     = badblocks_;
+    c.done          = ctx_.done;
+
+    return Checkpoint::write(ctx_.checkpoint_file,c);
+  }
+
+  static
+  bool
+  checkpoint_due(ScanContext &ctx_)
+  {
+    double now;
+
+    if(ctx_.checkpoint == NULL)
+      return false;
+
+    now = Time::get_monotonic();
+    if(now < ctx_.checkpoint_time)
+      return false;
+
+    ctx_.checkpoint_time = (now + ctx_.opts->checkpoint_interval);
+
+    return true;
+  }
+
+  /*
+    Blocks read so far: the distance covered less whatever was passed
+    over for not being included, plus anything from earlier passes.
+  */
+  static
+  uint64_t
+  processed(const ScanContext &ctx_,
+            const uint64_t     current_)
+  {
+    uint64_t rv;
+
+    rv  = (current_ - ctx_.start_block);
+    rv -= std::min(rv,ctx_.skipped);
+
+    return (ctx_.processed_base + rv);
+  }
+
+  /*
+    What a resumed scan had already read beyond where it is now.
+  */
+  static
+  void
+  add_resumed(ScanContext    &ctx_,
+              const uint64_t  current_)
+  {
+    BlockRanges::const_iterator i;
+
+    if(ctx_.resumed == NULL)
+      return;
+
+    for(i = ctx_.resumed->begin(); i != ctx_.resumed->end(); ++i)
+      if(i->second > current_)
+        ctx_.done.add(std::max(i->first,current_),i->second);
+  }
+
+  /*
+    Everything in [current_,issued_) has been read other than ranges
+    deferred by skipping ahead and reads still in flight. Only kept
+    for the checkpoint.
+  */
+  static
+  void
+  update_done(ScanContext    &ctx_,
+              const uint64_t  current_,
+              const uint64_t  issued_)
+  {
+    ctx_.done.clear();
+    if(issued_ > current_)
+      ctx_.done.add(current_,issued_);
+
+    if(ctx_.deferred)
+      for(size_t i = 0; i < ctx_.deferred->size(); i++)
+        ctx_.done.remove((*ctx_.deferred)[i].start,(*ctx_.deferred)[i].end);
+
+    if(ctx_.slots)
+      for(size_t i = 0; i < ctx_.slots->size(); i++)
+        if((*ctx_.slots)[i].busy)
+          ctx_.done.remove((*ctx_.slots)[i].block,
+                           (*ctx_.slots)[i].block + (*ctx_.slots)[i].stepping);
+
+    l::add_resumed(ctx_,current_);
+  }
+
+  static
+  void
+  update_status(ScanContext    &ctx_,
+                const uint64_t  current_,
+                const uint64_t  issued_)
+  {
+    ScanStatus *s = ctx_.status;
+    const std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+
+    if(ctx_.checkpoint)
+      l::update_done(ctx_,current_,issued_);
+
+    pthread_mutex_lock(&s->mutex);
+    s->current   = current_;
+    s->processed = l::processed(ctx_,current_);
+    s->badcount  = badblocks.size();
+    s->lastbad   = (badblocks.empty() ? 0 : badblocks.back());
+    pthread_mutex_unlock(&s->mutex);
+
+    if(l::checkpoint_due(ctx_))
+      l::write_checkpoint(ctx_,current_,badblocks);
+  }
+
+  static
+  void
+  record_latency(ScanLatency    &latency_,
+                 const uint64_t  block_,
+                 const uint64_t  count_,
+                 const double    start_time_)
+  {
+    uint64_t usec;
+
+    usec = ((Time::get_monotonic() - start_time_) * 1000000.0);
+
+    latency_.histogram.add(usec);
+    if(latency_.slow_usec && (usec >= latency_.slow_usec))
+      {
+        SlowBlock sb = {block_,count_,usec};
+        latency_.slowblocks.push_back(sb);
+      }
+  }
+
+  static
+  bool
+  slowblock_lt(const SlowBlock &a_,
+               const SlowBlock &b_)
+  {
+    return (a_.block < b_.block);
+  }
+
+  static
+  void
+  print_progress(ScanContext    &ctx_,
+                 const uint64_t  current_)
+  {
+    const std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+
+    if(ctx_.info == NULL)
+      return;
+
+    ctx_.info->print(current_,
+                     l::processed(ctx_,current_),
+                     badblocks.size(),
+                     (badblocks.empty() ? 0 : badblocks.back()));
+  }
+
+  /*
+    When only some ranges are being scanned move `block_` up to the
+    next of them, counting what was passed over, and return where
+    that range ends.
+  */
+  static
+  uint64_t
+  next_included(ScanContext &ctx_,
+                uint64_t    *block_)
+  {
+    uint64_t start;
+    uint64_t end;
+
+    if(ctx_.include == NULL)
+      return ctx_.end_block;
+
+    if(!ctx_.include->next(*block_,&start,&end))
+      start = end = ctx_.end_block;
+
+    start = std::min(std::max(start,*block_),ctx_.end_block);
+    end   = std::min(end,ctx_.end_block);
+
+    ctx_.skipped += (start - *block_);
+    *block_       = start;
+
+    return end;
+  }
+
+  /*
+    The range [block_,block_+blocks_) is known to have failed. Split
+    it in half and only descend into halves which fail again. Lower
+    half first so blocks are found in ascending order.
+  */
+  static
+  void
+  bisect_blocks(BlkDev                &blkdev_,
+                const uint64_t         block_,
+                const uint64_t         blocks_,
+                char                  *buf_,
+                const uint64_t         buflen_,
+                std::vector<uint64_t> &badblocks_)
+  {
+    int rv;
+    uint64_t half;
+
+    if(blocks_ == 1)
+      {
+        badblocks_.push_back(block_);
+        return;
+      }
+
+    half = (blocks_ / 2);
+
+    rv = blkdev_.read(block_,half,buf_,buflen_);
+    if(rv <= 0)
+      l::bisect_blocks(blkdev_,block_,half,buf_,buflen_,badblocks_);
+
+    rv = blkdev_.read(block_+half,blocks_-half,buf_,buflen_);
+    if(rv <= 0)
+      l::bisect_blocks(blkdev_,block_+half,blocks_-half,buf_,buflen_,badblocks_);
+  }
+
+  /*
+    Find the bad blocks within a chunk whose read failed. A single
+    block chunk is read once more before being marked bad.
+  */
+  static
+  void
+  reread_blocks(BlkDev                &blkdev_,
+                const uint64_t         block_,
+                const uint64_t         stepping_,
+                char                  *buf_,
+                const uint64_t         buflen_,
+                std::vector<uint64_t> &badblocks_)
+  {
+    int rv;
+
+    if(stepping_ == 1)
+      {
+        rv = blkdev_.read(block_,1,buf_,buflen_);
+        if(rv > 0)
+          return;
+      }
+
+    l::bisect_blocks(blkdev_,block_,stepping_,buf_,buflen_,badblocks_);
+  }
+
+  /*
+    0 (EOF) and OS level errors (errno values) end the scan. Larger
+    negative values are from the device and mean bad blocks.
+  */
+  static
+  bool
+  read_failed_fatally(const int64_t rv_)
+  {
+    return ((rv_ == 0) || ((rv_ < 0) && (rv_ > -256)));
+  }
+
+  /*
+    Read the parts of a chunk which aren't already known to be bad.
+    Returns the first fatal error, otherwise a media error if any
+    part had one, otherwise > 0.
+  */
+  static
+  int64_t
+  read_around_known(BlkDev                &blkdev_,
+                    const BlockRanges     &known_,
+                    const uint64_t         block_,
+                    const uint64_t         stepping_,
+                    char                  *buf_,
+                    const uint64_t         buflen_,
+                    std::vector<uint64_t> &badblocks_)
+  {
+    int64_t rv;
+    int64_t result;
+    uint64_t pos;
+    uint64_t gap_end;
+    uint64_t known_start;
+    uint64_t known_end;
+    const uint64_t chunk_end = (block_ + stepping_);
+
+    result = 1;
+    pos    = block_;
+    while(pos < chunk_end)
+      {
+        gap_end = chunk_end;
+        if(known_.next(pos,&known_start,&known_end))
+          {
+            if(known_start <= pos)
+              {
+                pos = known_end;
+                continue;
+              }
+
+            gap_end = std::min(known_start,chunk_end);
+          }
+
+        rv = blkdev_.read(pos,gap_end - pos,buf_,buflen_);
+        if(l::read_failed_fatally(rv))
+          return rv;
+        if(rv < 0)
+          {
+            l::reread_blocks(blkdev_,pos,gap_end - pos,buf_,buflen_,badblocks_);
+            result = rv;
+          }
+
+        pos = gap_end;
+      }
+
+    return result;
+  }
+
+  /*
+    AIMD: grow by the base stepping after each good read up to the max
+    transfer size and halve (keeping base alignment) after a bad one.
+  */
+  static
+  uint64_t
+  adapt_stepping(const ScanContext &ctx_,
+                 const uint64_t     stepping_,
+                 const bool         success_)
+  {
+    uint64_t stepping;
+
+    if(success_)
+      return std::min(stepping_ + ctx_.stepping,ctx_.max_stepping);
+
+    stepping = math::round_down(stepping_ / 2,ctx_.stepping);
+
+    return std::max(stepping,ctx_.stepping);
+  }
+
+  /*
+    Timed read of a chunk. On a media error the chunk is re-read to
+    find the individual bad blocks.
+  */
+  static
+  int64_t
+  read_chunk(ScanContext    &ctx_,
+             const uint64_t  block_,
+             const uint64_t  stepping_,
+             char           *buf_)
+  {
+    int64_t rv;
+    double start_time;
+
+    if(ctx_.known && ctx_.known->intersects(block_,block_ + stepping_))
+      return l::read_around_known(*ctx_.blkdev,
+                                  *ctx_.known,
+                                  block_,
+                                  stepping_,
+                                  buf_,
+                                  ctx_.buflen,
+                                  *ctx_.badblocks);
+
+    // exclude time held up by the rate limiter
+    start_time = (Time::get_monotonic() - ctx_.blkdev->throttled());
+    rv = ctx_.blkdev->read(block_,stepping_,buf_,ctx_.buflen);
+    l::record_latency(*ctx_.latency,block_,stepping_,start_time + ctx_.blkdev->throttled());
+    if((rv > 0) || l::read_failed_fatally(rv))
+      return rv;
+
+    l::print_progress(ctx_,block_);
+    l::reread_blocks(*ctx_.blkdev,block_,stepping_,buf_,ctx_.buflen,*ctx_.badblocks);
+
+    return rv;
+  }
+
+  /*
+    Revisit a range skipped over during the first pass: trim inward
+    from the start and then from the end until each hits an error and
+    finally scrape whatever remains in the middle. Returns > 0 when the
+    whole range was covered, 0 if stopped early, or a fatal error.
+    `range_` is narrowed to what is still unread as it goes so a
+    checkpoint counts the trimmed ends as done.
+  */
+  static
+  int64_t
+  scrape_range(ScanContext &ctx_,
+               BlockRange  &range_,
+               char        *buf_)
+  {
+    int64_t rv;
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t stepping;
+    const std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+
+    rv = 1;
+    lo = range_.start;
+    hi = range_.end;
+    while((lo < hi) && !signals::signaled_to_exit())
+      {
+        stepping = std::min(ctx_.stepping,hi - lo);
+        rv = l::read_chunk(ctx_,lo,stepping,buf_);
+        if(l::read_failed_fatally(rv))
+          return rv;
+        lo += stepping;
+        range_.start = lo;
+        l::update_status(ctx_,lo,ctx_.end_block);
+        if(rv < 0)
+          break;
+      }
+
+    while((lo < hi) && !signals::signaled_to_exit())
+      {
+        stepping = std::min(ctx_.stepping,hi - lo);
+        rv = l::read_chunk(ctx_,hi - stepping,stepping,buf_);
+        if(l::read_failed_fatally(rv))
+          return rv;
+        hi -= stepping;
+        range_.end = hi;
+        if(rv < 0)
+          break;
+      }
+
+    while((lo < hi) && !signals::signaled_to_exit())
+      {
+        if(ctx_.info && signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            l::print_progress(ctx_,lo);
+          }
+
+        if(badblocks.size() > ctx_.opts->max_errors)
+          break;
+
+        stepping = std::min(ctx_.stepping,hi - lo);
+        rv = l::read_chunk(ctx_,lo,stepping,buf_);
+        if(l::read_failed_fatally(rv))
+          return rv;
+        lo += stepping;
+        range_.start = lo;
+        l::update_status(ctx_,lo,ctx_.end_block);
+      }
+
+    return ((lo < hi) ? 0 : 1);
+  }
+
+  /*
+    Queue [start_,end_) to be revisited. Only the included parts are
+    kept; the rest is counted as skipped.
+  */
+  static
+  void
+  defer_range(ScanContext             &ctx_,
+              uint64_t                 start_,
+              const uint64_t           end_,
+              std::vector<BlockRange> &deferred_)
+  {
+    uint64_t start;
+    uint64_t end;
+    BlockRange range;
+
+    if(ctx_.include == NULL)
+      {
+        range.start = start_;
+        range.end   = end_;
+        deferred_.push_back(range);
+        return;
+      }
+
+    ctx_.skipped += (end_ - start_);
+    while((start_ < end_) && ctx_.include->next(start_,&start,&end))
+      {
+        range.start = std::max(start,start_);
+        range.end   = std::min(end,end_);
+        if(range.start >= range.end)
+          break;
+
+        deferred_.push_back(range);
+        ctx_.skipped -= (range.end - range.start);
+
+        start_ = range.end;
+      }
+  }
+
+  static
+  uint64_t
+  skip_watermark(const std::vector<BlockRange> &deferred_,
+                 const uint64_t                 block_)
+  {
+    if(deferred_.empty())
+      return block_;
+
+    return std::min(deferred_[0].start,block_);
+  }
+
+  static
+  int
+  scan_loop(ScanContext &ctx_,
+            char        *buf_)
+  {
+    int rv;
+    uint64_t skip;
+    uint64_t block;
+    uint64_t failures;
+    uint64_t stepping;
+    uint64_t adaptive;
+    uint64_t range_end;
+    std::vector<BlockRange> deferred;
+    std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+    const size_t first_new = badblocks.size();
+
+    l::print_progress(ctx_,ctx_.start_block);
+
+    ctx_.deferred = &deferred;
+
+    rv       = 0;
+    skip     = 0;
+    failures = 0;
+    block    = ctx_.start_block;
+    adaptive = ctx_.stepping;
+    while(block < ctx_.end_block)
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        if(ctx_.info && signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            l::print_progress(ctx_,block);
+          }
+
+        range_end = l::next_included(ctx_,&block);
+        if(block >= ctx_.end_block)
+          break;
+
+        if(ctx_.opts->adaptive)
+          stepping = std::min(adaptive,range_end - block);
+        else
+          stepping = std::min(l::trim_stepping(*ctx_.blkdev,block,ctx_.stepping),
+                              range_end - block);
+
+        rv = l::read_chunk(ctx_,block,stepping,buf_);
+        if(l::read_failed_fatally(rv))
+          break;
+
+        block    += stepping;
+        adaptive  = l::adapt_stepping(ctx_,adaptive,(rv > 0));
+        failures  = ((rv > 0) ? 0 : (failures + 1));
+        skip      = ((rv > 0) ? 0 : skip);
+
+        /*
+          After enough consecutive failures jump ahead by a growing
+          distance and leave the skipped range for later.
+        */
+        if(ctx_.opts->skip_after &&
+           (failures >= ctx_.opts->skip_after) &&
+           (block < ctx_.end_block))
+          {
+            uint64_t end;
+
+            skip = ((skip == 0) ?
+                    (ctx_.stepping * ctx_.opts->skip_after) :
+                    (skip * 2));
+
+            end = std::min(block + skip,ctx_.end_block);
+            l::defer_range(ctx_,block,end,deferred);
+
+            block    = end;
+            failures = 0;
+          }
+
+        l::update_status(ctx_,l::skip_watermark(deferred,block),block);
+
+        if(badblocks.size() > ctx_.opts->max_errors)
+          break;
+      }
+
+    if((block >= ctx_.end_block) &&
+       !l::read_failed_fatally(rv) &&
+       (badblocks.size() <= ctx_.opts->max_errors))
+      {
+        while(!deferred.empty())
+          {
+            rv = l::scrape_range(ctx_,deferred[0],buf_);
+            if(rv <= 0)
+              break;
+            deferred.erase(deferred.begin());
+          }
+
+        std::sort(badblocks.begin() + first_new,badblocks.end());
+      }
+
+    l::update_status(ctx_,l::skip_watermark(deferred,block),block);
+    l::print_progress(ctx_,l::skip_watermark(deferred,block));
+
+    ctx_.deferred = NULL;
+
+    return rv;
+  }
+
+  struct SampleStats
+  {
+    uint64_t                chunks;
+    uint64_t                samples;
+    uint64_t                failed;
+    uint64_t                neighbours;
+    uint64_t                neighbours_failed;
+    std::vector<BlockRange> hits;
+  };
+
+  /*
+    Read the `chunk_`th chunk of the range. It counts as failed if any
+    block in it is bad including those already known to be.
+  */
+  static
+  int64_t
+  read_sample(ScanContext    &ctx_,
+              const uint64_t  chunk_,
+              char           *buf_,
+              BlockRange     *range_,
+              bool           *failed_)
+  {
+    int64_t rv;
+
+    range_->start = (ctx_.start_block + (chunk_ * ctx_.stepping));
+    range_->end   = (range_->start + l::trim_stepping(*ctx_.blkdev,range_->start,ctx_.stepping));
+
+    rv = l::read_chunk(ctx_,range_->start,range_->end - range_->start,buf_);
+
+    *failed_ = ((rv < 0) ||
+                (ctx_.known && ctx_.known->intersects(range_->start,range_->end)));
+
+    return rv;
+  }
+
+  /*
+    Read outward from a failed sample, a chunk at a time and no further
+    than its stratum, until a read succeeds in each direction.
+  */
+  static
+  int64_t
+  sample_neighbours(ScanContext    &ctx_,
+                    const uint64_t  first_,
+                    const uint64_t  last_,
+                    const uint64_t  chunk_,
+                    char           *buf_,
+                    SampleStats    &stats_)
+  {
+    int64_t rv;
+    bool failed;
+    BlockRange range;
+    const uint64_t limit = 8;
+
+    for(uint64_t c = chunk_; (c > first_) && ((chunk_ - c) < limit); )
+      {
+        rv = l::read_sample(ctx_,--c,buf_,&range,&failed);
+        if(l::read_failed_fatally(rv))
+          return rv;
+
+        stats_.neighbours++;
+        if(!failed)
+          break;
+        stats_.neighbours_failed++;
+      }
+
+    for(uint64_t c = chunk_ + 1; (c < last_) && ((c - chunk_) <= limit); c++)
+      {
+        rv = l::read_sample(ctx_,c,buf_,&range,&failed);
+        if(l::read_failed_fatally(rv))
+          return rv;
+
+        stats_.neighbours++;
+        if(!failed)
+          break;
+        stats_.neighbours_failed++;
+      }
+
+    return 1;
+  }
+
+  /*
+    Split the range's chunks into `samples` equal strata and read one
+    at random from each. Going through the strata in order keeps the
+    reads in LBA order.
+  */
+  static
+  int
+  scan_sample(ScanContext &ctx_,
+              char        *buf_,
+              SampleStats &stats_)
+  {
+    int64_t rv;
+    bool failed;
+    uint64_t first;
+    uint64_t last;
+    uint64_t chunk;
+    uint64_t samples;
+    uint64_t current;
+    BlockRange range;
+    const std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+
+    rnd::init();
+
+    stats_.chunks            = math::round_up(ctx_.end_block - ctx_.start_block,
+                                              ctx_.stepping) / ctx_.stepping;
+    stats_.samples           = 0;
+    stats_.failed            = 0;
+    stats_.neighbours        = 0;
+    stats_.neighbours_failed = 0;
+
+    samples = std::min(ctx_.opts->sample,stats_.chunks);
+
+    l::print_progress(ctx_,ctx_.start_block);
+
+    rv    = 1;
+    first = 0;
+    for(uint64_t i = 0; i < samples; i++)
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        if(ctx_.info && signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            l::print_progress(ctx_,ctx_.start_block + (first * ctx_.stepping));
+          }
+
+        // (i+1) * chunks / samples without overflowing
+        last  = (((i + 1) * (stats_.chunks / samples)) +
+                 (((i + 1) * (stats_.chunks % samples)) / samples));
+        chunk = (first + (rnd::u64() % (last - first)));
+
+        rv = l::read_sample(ctx_,chunk,buf_,&range,&failed);
+        if(l::read_failed_fatally(rv))
+          break;
+
+        stats_.samples++;
+        if(failed)
+          {
+            stats_.failed++;
+            stats_.hits.push_back(range);
+
+            rv = l::sample_neighbours(ctx_,first,last,chunk,buf_,stats_);
+            if(l::read_failed_fatally(rv))
+              break;
+          }
+
+        first = last;
+        current = std::min(ctx_.start_block + (first * ctx_.stepping),ctx_.end_block);
+        l::update_status(ctx_,current,current);
+
+        if(badblocks.size() > ctx_.opts->max_errors)
+          break;
+      }
+
+    l::print_progress(ctx_,ctx_.status->current);
+
+    return ((rv > 0) ? 0 : rv);
+  }
+
+  /*
+    Wilson score interval for k failures in n samples at ~95%
+    confidence. Unlike the normal approximation it behaves when k is 0
+    or close to n which is the usual case here.
+  */
+  static
+  void
+  wilson_interval(const uint64_t  k_,
+                  const uint64_t  n_,
+                  double         *lo_,
+                  double         *hi_)
+  {
+    double p;
+    double n;
+    double center;
+    double margin;
+    double denominator;
+    const double z = 1.959964;
+
+    n           = n_;
+    p           = (k_ / n);
+    denominator = (1.0 + ((z * z) / n));
+    center      = ((p + ((z * z) / (2.0 * n))) / denominator);
+    margin      = ((z * std::sqrt(((p * (1.0 - p)) / n) + ((z * z) / (4.0 * n * n)))) /
+                   denominator);
+
+    *lo_ = std::max(0.0,center - margin);
+    *hi_ = std::min(1.0,center + margin);
+  }
+
+  static
+  void
+  print_sample(const SampleStats &stats_)
+  {
+    double p;
+    double lo;
+    double hi;
+
+    std::cout << "samples: "
+              << stats_.samples
+              << " of "
+              << stats_.chunks
+              << " chunks; failed: "
+              << stats_.failed
+              << std::endl;
+
+    if(stats_.samples == 0)
+      return;
+
+    p = ((double)stats_.failed / stats_.samples);
+    l::wilson_interval(stats_.failed,stats_.samples,&lo,&hi);
+
+    std::cout << std::fixed
+              << std::setprecision(4)
+              << "estimated failing chunks: "
+              << (p * 100.0)
+              << "% (95% CI: "
+              << (lo * 100.0)
+              << "% - "
+              << (hi * 100.0)
+              << "%); ~"
+              << (uint64_t)(p * stats_.chunks)
+              << " of "
+              << stats_.chunks
+              << std::endl;
+
+    if(stats_.neighbours)
+      std::cout << "neighbouring chunks read: "
+                << stats_.neighbours
+                << "; failed: "
+                << stats_.neighbours_failed
+                << std::endl;
+
+    for(size_t i = 0; i < stats_.hits.size(); i++)
+      std::cout << "failed sample: "
+                << stats_.hits[i].start
+                << " - "
+                << (stats_.hits[i].end - 1)
+                << std::endl;
+  }
+
+  static
+  uint64_t
+  lowest_inflight(const std::vector<AIOSlot> &slots_,
+                  const uint64_t              block_)
+  {
+    uint64_t rv;
+
+    rv = block_;
+    for(size_t i = 0; i < slots_.size(); i++)
+      {
+        if(slots_[i].busy && (slots_[i].block < rv))
+          rv = slots_[i].block;
+      }
+
+    return rv;
+  }
+
+  /*
+    Same as scan_loop but keeps up to `slots_.size()` reads in flight
+    via io_uring. Completions arrive out of order so any bad blocks
+    found are sorted once done to match what scan_loop would produce.
+  */
+  static
+  int
+  scan_loop_async(ScanContext          &ctx_,
+                  std::vector<AIOSlot> &slots_)
+  {
+    int rv;
+    int err;
+    bool done;
+    uint64_t tag;
+    uint64_t block;
+    uint64_t unread;
+    uint64_t inflight;
+    uint64_t stepping;
+    uint64_t range_end;
+    int64_t  blocks;
+    BlkDev &blkdev = *ctx_.blkdev;
+    std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+    const size_t first_new = badblocks.size();
+
+    l::print_progress(ctx_,ctx_.start_block);
+
+    ctx_.slots = &slots_;
+
+    rv       = 0;
+    err      = 0;
+    done     = false;
+    inflight = 0;
+    block    = ctx_.start_block;
+    unread   = ctx_.end_block;
+    while(true)
+      {
+        if(signals::signaled_to_exit())
+          done = true;
+
+        if(ctx_.info && signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            l::print_progress(ctx_,l::lowest_inflight(slots_,block));
+          }
+
+        for(size_t i = 0; !done && (i < slots_.size()) && (block < ctx_.end_block); i++)
+          {
+            if(slots_[i].busy)
+              continue;
+
+            range_end = l::next_included(ctx_,&block);
+            if(block >= ctx_.end_block)
+              break;
+
+            stepping = std::min(l::trim_stepping(blkdev,block,ctx_.stepping),
+                                range_end - block);
+
+            if(ctx_.known && ctx_.known->intersects(block,block + stepping))
+              {
+                blocks = l::read_around_known(blkdev,
+                                              *ctx_.known,
+                                              block,
+                                              stepping,
+                                              slots_[i].buf,
+                                              ctx_.buflen,
+                                              badblocks);
+                if(l::read_failed_fatally(blocks))
+                  {
+                    if(blocks < 0)
+                      err = blocks;
+                    unread = std::min(unread,block);
+                    done   = true;
+                    break;
+                  }
+
+                block += stepping;
+                continue;
+              }
+
+            rv = blkdev.aio_read(block,stepping,slots_[i].buf,ctx_.buflen,i);
+            if(rv < 0)
+              break;
+
+            slots_[i].block      = block;
+            slots_[i].stepping   = stepping;
+            slots_[i].start_time = Time::get_monotonic();
+            slots_[i].busy       = true;
+
+            block += stepping;
+            inflight++;
+          }
+
+        if(inflight == 0)
+          break;
+
+        rv = blkdev.aio_submit();
+        if((rv < 0) && (rv != -EINTR) && (rv != -EAGAIN))
+          {
+            err  = rv;
+            done = true;
+          }
+
+        rv = blkdev.aio_wait(&tag,&blocks);
+        if(rv == -EINTR)
+          continue;
+        if(rv < 0)
+          {
+            err = rv;
+            break;
+          }
+
+        AIOSlot &slot = slots_[tag];
+
+        inflight--;
+
+        l::record_latency(*ctx_.latency,slot.block,slot.stepping,slot.start_time);
+
+        if((blocks == 0) || ((blocks < 0) && (blocks > -256)))
+          {
+            if(blocks < 0)
+              err = blocks;
+            unread = std::min(unread,slot.block);
+            done   = true;
+          }
+        else if(blocks < 0)
+          {
+            l::print_progress(ctx_,slot.block);
+
+            l::reread_blocks(blkdev,slot.block,slot.stepping,slot.buf,ctx_.buflen,badblocks);
+
+            if(badblocks.size() > ctx_.opts->max_errors)
+              done = true;
+          }
+
+        slot.busy = false;
+
+        l::update_status(ctx_,
+                         l::lowest_inflight(slots_,std::min(block,unread)),
+                         std::min(block,unread));
+      }
+
+    std::sort(badblocks.begin() + first_new,badblocks.end());
+    std::sort(ctx_.latency->slowblocks.begin(),
+              ctx_.latency->slowblocks.end(),
+              l::slowblock_lt);
+
+    l::update_status(ctx_,
+                     l::lowest_inflight(slots_,std::min(block,unread)),
+                     std::min(block,unread));
+    l::print_progress(ctx_,l::lowest_inflight(slots_,std::min(block,unread)));
+
+    ctx_.slots = NULL;
+
+    return err;
+  }
+
+  struct ScanWorker
+  {
+    pthread_t              thread;
+    BlkDev                 blkdev;
+    char                  *buf;
+    uint64_t               buflen;
+    uint64_t               stepping;
+    uint64_t               block;
+    uint64_t               end_block;
+    uint64_t               stride;
+    uint64_t               max_errors;
+    std::vector<uint64_t>  badblocks;
+    const BlockRanges     *known;
+    const BlockRanges     *include;
+    ScanLatency            latency;
+    ScanStatus            *status;
+    int                    rv;
+  };
+
+  /*
+    How far a worker should jump ahead, in whole strides, to get to
+    its next chunk within an included range. Ranges start chunk
+    aligned so a chunk is either out or starts in one.
+  */
+  static
+  uint64_t
+  worker_skip(const ScanWorker *w_,
+              const uint64_t    stride_)
+  {
+    uint64_t start;
+    uint64_t end;
+
+    if(w_->include == NULL)
+      return 0;
+
+    if(!w_->include->next(w_->block,&start,&end))
+      return (w_->end_block - w_->block);
+    if(start <= w_->block)
+      return 0;
+
+    return std::max(math::round_down(start - w_->block,stride_),stride_);
+  }
+
+  /*
+    Zone ranges end at write pointers, part way through a chunk, and
+    the rest of the chunk must not be read.
+  */
+  static
+  uint64_t
+  worker_clip(const ScanWorker *w_,
+              const uint64_t    stepping_)
+  {
+    uint64_t start;
+    uint64_t end;
+
+    if(w_->include == NULL)
+      return stepping_;
+    if(!w_->include->next(w_->block,&start,&end))
+      return stepping_;
+
+    return std::min(stepping_,end - w_->block);
+  }
+
+  /*
+    Each worker reads every `stride`th chunk starting from its own
+    offset so the threads sweep the device together as interleaved
+    stripes rather than as distant independent regions. Bad blocks are
+    only added to `badblocks` under the status mutex so the main
+    thread can checkpoint them.
+  */
+  static
+  void*
+  scan_worker(void *data_)
+  {
+    int64_t rv;
+    bool stop;
+    uint64_t skip;
+    uint64_t stepping;
+    double start_time;
+    std::vector<uint64_t> badblocks;
+    ScanWorker *w = (ScanWorker*)data_;
+    ScanStatus *s = w->status;
+    const uint64_t stride = (w->stepping * w->stride);
+
+    rv   = 0;
+    stop = false;
+    while(!stop && (w->block < w->end_block))
+      {
+        if(signals::signaled_to_exit())
+          break;
+
+        skip = l::worker_skip(w,stride);
+        if(skip)
+          {
+            pthread_mutex_lock(&s->mutex);
+            w->block = std::min(w->block + skip,w->end_block);
+            pthread_mutex_unlock(&s->mutex);
+            continue;
+          }
+
+        stepping = l::trim_stepping(w->blkdev,w->block,w->stepping);
+        stepping = l::worker_clip(w,stepping);
+
+        badblocks.clear();
+        if(w->known && w->known->intersects(w->block,w->block + stepping))
+          {
+            rv = l::read_around_known(w->blkdev,*w->known,w->block,stepping,
+                                      w->buf,w->buflen,badblocks);
+            if(l::read_failed_fatally(rv))
+              break;
+          }
+        else
+          {
+            start_time = (Time::get_monotonic() - w->blkdev.throttled());
+            rv = w->blkdev.read(w->block,stepping,w->buf,w->buflen);
+            l::record_latency(w->latency,w->block,stepping,start_time + w->blkdev.throttled());
+            if(l::read_failed_fatally(rv))
+              break;
+            if(rv < 0)
+              l::reread_blocks(w->blkdev,w->block,stepping,w->buf,w->buflen,badblocks);
+          }
+
+        pthread_mutex_lock(&s->mutex);
+        w->block     += stride;
+        s->processed += stepping;
+        if(!badblocks.empty())
+          {
+            w->badblocks.insert(w->badblocks.end(),badblocks.begin(),badblocks.end());
+            s->badcount += badblocks.size();
+            s->lastbad   = badblocks.back();
+            if(s->badcount > w->max_errors)
+              s->stop = true;
+          }
+        stop = s->stop;
+        pthread_mutex_unlock(&s->mutex);
+
+        rv = 0;
+      }
+
+    pthread_mutex_lock(&s->mutex);
+    w->rv = rv;
+    s->finished++;
+    pthread_mutex_unlock(&s->mutex);
+
+    return NULL;
+  }
+
+  static
+  uint64_t
+  lowest_worker_block(const std::vector<ScanWorker*> &workers_,
+                      const uint64_t                  end_block_)
+  {
+    uint64_t rv;
+
+    rv = end_block_;
+    for(size_t i = 0; i < workers_.size(); i++)
+      rv = std::min(rv,workers_[i]->block);
+
+    return rv;
+  }
+
+  /*
+    The `i`th worker reads the chunks at start + (i * stepping) plus
+    whole strides so those of its chunks from `current_` up to where
+    it is now have been read.
+  */
+  static
+  void
+  update_worker_done(ScanContext                    &ctx_,
+                     const std::vector<ScanWorker*> &workers_,
+                     const uint64_t                  current_)
+  {
+    uint64_t end;
+    uint64_t first;
+    const uint64_t stride = (ctx_.stepping * workers_.size());
+
+    ctx_.done.clear();
+    for(size_t i = 0; i < workers_.size(); i++)
+      {
+        first = (ctx_.start_block + (i * ctx_.stepping));
+        if(first < current_)
+          first += math::round_up(current_ - first,stride);
+
+        end = std::min(workers_[i]->block,ctx_.end_block);
+        for(uint64_t b = first; b < end; b += stride)
+          ctx_.done.add(b,std::min(b + ctx_.stepping,ctx_.end_block));
+      }
+
+    l::add_resumed(ctx_,current_);
+  }
+
+  static
+  int
+  spawn_thread(pthread_t  *thread_,
+               void*     (*func_)(void*),
+               void       *data_)
+  {
+    int rv;
+    sigset_t sigset_old;
+    sigset_t sigset_new;
+
+    sigfillset(&sigset_new);
+    pthread_sigmask(SIG_SETMASK,&sigset_new,&sigset_old);
+
+    rv = pthread_create(thread_,NULL,func_,data_);
+
+    pthread_sigmask(SIG_SETMASK,&sigset_old,NULL);
+
+    return -rv;
+  }
+
+  static
+  int
+  scan_threaded(ScanContext &ctx_,
+                BufferPool  &pool_)
+  {
+    int rv;
+    uint64_t spawned;
+    ScanStatus &status = *ctx_.status;
+    const Options &opts = *ctx_.opts;
+    std::vector<ScanWorker*> workers;
+    std::vector<uint64_t> &badblocks = *ctx_.badblocks;
+    const size_t first_new = badblocks.size();
+
+    pthread_mutex_lock(&status.mutex);
+    status.processed = ctx_.processed_base;
+    status.badcount  = first_new;
+    status.lastbad   = (badblocks.empty() ? 0 : badblocks.back());
+    status.finished  = 0;
+    status.stop      = false;
+    pthread_mutex_unlock(&status.mutex);
+
+    for(uint64_t i = 0; i < opts.threads; i++)
+      {
+        ScanWorker *w = new ScanWorker();
+
+        w->buf        = pool_.get();
+        w->buflen     = ctx_.buflen;
+        w->stepping   = ctx_.stepping;
+        w->block      = (ctx_.start_block + (i * ctx_.stepping));
+        w->end_block  = ctx_.end_block;
+        w->stride     = opts.threads;
+        w->max_errors = opts.max_errors;
+        w->known      = ctx_.known;
+        w->include    = ctx_.include;
+        w->status     = &status;
+        w->rv         = 0;
+
+        w->latency.slow_usec = ctx_.latency->slow_usec;
+        workers.push_back(w);
+
+        w->blkdev.set_file_block_size(l::file_block_size(opts));
+        rv = w->blkdev.open_read(ctx_.device);
+        if(rv < 0)
+          goto cleanup;
+        l::set_blkdev_rwtype(w->blkdev,opts.rwtype);
+        w->blkdev.set_rate_limiter(ctx_.blkdev->rate_limiter());
+        if(opts.direct)
+          {
+            rv = w->blkdev.set_direct_io(true);
+            if(rv < 0)
+              goto cleanup;
+          }
+      }
+
+    l::print_progress(ctx_,ctx_.start_block);
+
+    rv = 0;
+    spawned = 0;
+    for(; spawned < workers.size(); spawned++)
+      {
+        rv = l::spawn_thread(&workers[spawned]->thread,
+                             l::scan_worker,
+                             workers[spawned]);
+        if(rv < 0)
+          break;
+      }
+
+    while(true)
+      {
+        bool finished;
+
+        if(signals::signaled_to_exit() || (rv < 0))
+          {
+            pthread_mutex_lock(&status.mutex);
+            status.stop = true;
+            pthread_mutex_unlock(&status.mutex);
+          }
+
+        pthread_mutex_lock(&status.mutex);
+        status.current = l::lowest_worker_block(workers,ctx_.end_block);
+        if(ctx_.checkpoint)
+          l::update_worker_done(ctx_,workers,status.current);
+        finished = (status.finished == spawned);
+        if(ctx_.info && (finished || signals::dec(SIGALRM)))
+          {
+            signals::alarm(1);
+            ctx_.info->print(status.current,
+                             status.processed,
+                             status.badcount,
+                             status.lastbad);
+          }
+        if(!finished && l::checkpoint_due(ctx_))
+          {
+            std::vector<uint64_t> found(badblocks);
+
+            for(size_t i = 0; i < workers.size(); i++)
+              found.insert(found.end(),
+                           workers[i]->badblocks.begin(),
+                           workers[i]->badblocks.end());
+
+            l::write_checkpoint(ctx_,status.current,found);
+          }
+        pthread_mutex_unlock(&status.mutex);
+
+        if(finished)
+          break;
+
+        ::usleep(100 * 1000);
+      }
+
+    for(uint64_t i = 0; i < spawned; i++)
+      {
+        pthread_join(workers[i]->thread,NULL);
+        if((rv == 0) && (workers[i]->rv < 0))
+          rv = workers[i]->rv;
+        badblocks.insert(badblocks.end(),
+                         workers[i]->badblocks.begin(),
+                         workers[i]->badblocks.end());
+        ctx_.latency->histogram.merge(workers[i]->latency.histogram);
+        ctx_.latency->slowblocks.insert(ctx_.latency->slowblocks.end(),
+                                        workers[i]->latency.slowblocks.begin(),
+                                        workers[i]->latency.slowblocks.end());
+      }
+
+    std::sort(badblocks.begin() + first_new,badblocks.end());
+    std::sort(ctx_.latency->slowblocks.begin(),
+              ctx_.latency->slowblocks.end(),
+              l::slowblock_lt);
+
+  cleanup:
+    for(size_t i = 0; i < workers.size(); i++)
+      {
+        pool_.put(workers[i]->buf);
+        delete workers[i];
+      }
+
+    return rv;
+  }
+
+  /*
+    Ranges of the device holding file data of the filesystem mounted
+    at `mountpoint_` (which must be the device or one of its
+    partitions) rounded out to whole chunks.
+  */
   static
   int
-  scan_loop(BlkDev                &blkdev_,
-            const uint64_t         stepping_,
-            const uint64_t         start_block_,
-            const uint64_t         end_block_,
-            char                  *buf_,
-            const uint64_t         buflen_,
-            std::vector<uint64_t> &badblocks_,
-            const uint64_t         max_errors_)
+  allocated_ranges(const BlkDev      &blkdev_,
+                   const std::string &mountpoint_,
+                   const uint64_t     stepping_,
+                   BlockRanges       &ranges_)
   {
     int rv;
-    uint64_t block;
-    uint64_t stepping;
-    InfoPrinter info;
-    const double start_time = Time::get_monotonic();
+    int64_t offset;
+    struct stat st;
+    BlockToFileMapper b2fm;
+    BlockToFileMapper::BlockMap::const_iterator i;
+
+    rv = ::fstat(blkdev_.fd(),&st);
+    if(rv == -1)
+      return -errno;
 
-    info.init(start_block_,end_block_,&badblocks_);
-    info.print(start_block_);
+    offset = FileToBlkDev::offset(mountpoint_,st.st_rdev);
+    if(offset < 0)
+      return offset;
+    offset /= blkdev_.logical_block_size();
 
-    block = start_block_;
-    while(block < end_block_)
+    rv = b2fm.scan(mountpoint_);
+    if(rv < 0)
+      return rv;
+    if(rv == 0)
+      return -ENOENT;
+
+    const BlockToFileMapper::BlockMap &blockmap = b2fm.blockmap();
+    for(i = blockmap.begin(); i != blockmap.end(); ++i)
+      ranges_.add(math::round_down(offset + i->first,stepping_),
+                  math::round_up(offset + i->first + i->second.first,stepping_));
+
+    return 0;
+  }
+
+  static
+  void
+  unallocated_ranges(const BlockRanges &allocated_,
+                     const uint64_t     start_,
+                     const uint64_t     end_,
+                     BlockRanges       &ranges_)
+  {
+    uint64_t block;
+    BlockRanges::const_iterator i;
+
+    block = start_;
+    for(i = allocated_.begin(); i != allocated_.end(); ++i)
       {
-        if(signals::signaled_to_exit())
-          break;
+        if(i->first > block)
+          ranges_.add(block,std::min(i->first,end_));
+        block = std::max(block,i->second);
+      }
 
-        if(signals::dec(SIGALRM))
-          {
-            signals::alarm(1);
-            info.print(block);
-          }
+    ranges_.add(block,end_);
+  }
 
-        stepping = l::trim_stepping(blkdev_,block,stepping_);
+  /*
+    On zoned devices only the blocks below a sequential zone's write
+    pointer hold data. Reading past it returns zeros at best and fails
+    on host managed drives. Write pointers needn't be chunk aligned so
+    reads are clipped to the end of the range.
+  */
+  static
+  int
+  written_ranges(BlkDev                    &blkdev_,
+                 std::vector<BlkDev::Zone> &zones_,
+                 BlockRanges               &ranges_)
+  {
+    int rv;
 
-        rv = blkdev_.read(block,stepping,buf_,buflen_);
-        if(rv > 0)
-          {
-            block += stepping;
-            continue;
-          }
+    rv = blkdev_.report_zones(zones_);
+    if(rv < 0)
+      return rv;
 
-        if(rv == 0)
-          break;
-        if(rv > -256)
-          break;
+    for(size_t i = 0; i < zones_.size(); i++)
+      ranges_.add(zones_[i].start,zones_[i].readable_end());
 
-        info.print(block);
+    return 0;
+  }
 
-        for(uint64_t i = 0; i < stepping; i++)
-          {
-            rv = blkdev_.read(block+i,1,buf_,buflen_);
-            if(rv > 0)
-              continue;
-            badblocks_.push_back(block+i);
-          }
+  /*
+    Ranges of a regular file holding data. Holes read back as zeros
+    without touching any media so are skipped entirely.
+  */
+  static
+  int
+  data_ranges(const BlkDev   &blkdev_,
+              const uint64_t  stepping_,
+              BlockRanges    &ranges_)
+  {
+    off_t data;
+    off_t hole;
+    const off_t size = blkdev_.size_in_bytes();
+    const uint64_t lbs = blkdev_.logical_block_size();
 
-        if(badblocks_.size() > max_errors_)
-          break;
-      }
+    data = 0;
+    while(data < size)
+      {
+        data = ::lseek(blkdev_.fd(),data,SEEK_DATA);
+        if(data == -1)
+          return ((errno == ENXIO) ? 0 : -errno);
 
-    info.print(block);
+        hole = ::lseek(blkdev_.fd(),data,SEEK_HOLE);
+        if(hole == -1)
+          return -errno;
 
-    return rv;
+        ranges_.add(math::round_down(data / lbs,stepping_),
+                    std::min(math::round_up((hole + lbs - 1) / lbs,stepping_),
+                             blkdev_.logical_block_count()));
+
+        data = hole;
+      }
+
+    return 0;
   }
 
   static
   AppError
   scan(BlkDev                &blkdev_,
+       const std::string     &device_,
        const Options         &opts_,
-       std::vector<uint64_t> &badblocks_)
+       std::vector<uint64_t> &badblocks_,
+       ScanLatency           &latency_,
+       ScanStatus            &status_,
+       const ScanCheckpoint  *resume_,
+       const std::string     &checkpoint_file_,
+       const bool             verbose_)
   {
     int rv;
+    BufferPool pool;
+    InfoPrinter info;
+    ScanContext ctx;
+    BlockRanges known;
+    BlockRanges allocated;
+    BlockRanges unallocated;
+    BlockRanges readable;
+    ScanCheckpoint checkpoint;
+    bool aio;
     char *buf;
-    uint64_t buflen;
-    uint64_t start_block;
-    uint64_t end_block;
-    uint64_t stepping;
+    SampleStats sample;
+    uint64_t total_blocks;
+    std::vector<AIOSlot> slots;
+    std::vector<BlkDev::Zone> zones;
+    std::vector<BlockRanges> limited;
+    std::vector<const BlockRanges*> passes;
 
-    stepping    = ((opts_.stepping == 0) ?
-                   blkdev_.block_stepping() :
-                   opts_.stepping);
-    buflen      = (stepping * blkdev_.logical_block_size());
-    start_block = math::round_down(opts_.start_block,stepping);
-    end_block   = std::min(opts_.end_block,blkdev_.logical_block_count());
-    end_block   = math::round_up(end_block,stepping);
-    end_block   = std::min(end_block,blkdev_.logical_block_count());
-
-    std::cout << "start block: "
-              << start_block << std::endl
-              << "end block: "
-              << end_block << std::endl
-              << "stepping: "
-              << stepping << std::endl
-              << "logical block size: "
-              << blkdev_.logical_block_size() << std::endl
-              << "physical block size: "
-              << blkdev_.physical_block_size() << std::endl
-              << "read size: "
-              << stepping << " blocks / "
-              << stepping * blkdev_.logical_block_size() << " bytes"
-              << std::endl;
+    ctx.blkdev       = &blkdev_;
+    ctx.device       = device_;
+    ctx.opts         = &opts_;
+    ctx.badblocks    = &badblocks_;
+    ctx.known        = NULL;
+    ctx.include      = NULL;
+    ctx.skipped      = 0;
+    ctx.processed_base = 0;
+    ctx.latency      = &latency_;
+    ctx.status       = &status_;
+    ctx.info         = (verbose_ ? &info : NULL);
+    ctx.elapsed      = 0;
+    ctx.deferred     = NULL;
+    ctx.slots        = NULL;
+    ctx.resumed      = (resume_ ? &resume_->done : NULL);
+    ctx.stepping     = ((opts_.stepping == 0) ?
+                        blkdev_.block_stepping() :
+                        opts_.stepping);
+    ctx.start_block  = math::round_down(opts_.start_block,ctx.stepping);
+    ctx.end_block    = std::min(opts_.end_block,blkdev_.logical_block_count());
+    ctx.end_block    = math::round_up(ctx.end_block,ctx.stepping);
+    ctx.end_block    = std::min(ctx.end_block,blkdev_.logical_block_count());
+    if(resume_)
+      {
+        ctx.elapsed     = resume_->elapsed;
+        ctx.stepping    = resume_->stepping;
+        ctx.start_block = resume_->current_block;
+        ctx.end_block   = std::min(resume_->end_block,blkdev_.logical_block_count());
+      }
+    ctx.max_stepping = ctx.stepping;
+    if(opts_.adaptive)
+      ctx.max_stepping = std::max(ctx.stepping,
+                                  math::round_down(blkdev_.max_transfer_blocks(),
+                                                   ctx.stepping));
+    ctx.buflen       = (ctx.max_stepping * blkdev_.logical_block_size());
 
-    signals::alarm(1);
+    if(!opts_.reverify_known && !badblocks_.empty())
+      {
+        known.add(badblocks_);
+        ctx.known = &known;
+      }
 
-    std::cout << "\r\x1B[2KScanning: "
-              << start_block
-              << " - "
-              << end_block
-              << std::endl;
+    /*
+      What the interrupted scan read beyond its watermark is passed
+      over the same way as known bad blocks.
+    */
+    if(resume_ && !resume_->done.empty())
+      {
+        BlockRanges::const_iterator i;
 
-    buf = new char[buflen];
-    rv = l::scan_loop(blkdev_,
-                      stepping,
-                      start_block,
-                      end_block,
-                      buf,
-                      buflen,
-                      badblocks_,
-                      opts_.max_errors);
-    delete[] buf;
+        for(i = resume_->done.begin(); i != resume_->done.end(); ++i)
+          known.add(i->first,i->second);
+        ctx.known = &known;
+      }
 
-    std::cout << std::endl;
+    total_blocks = (ctx.end_block - ctx.start_block);
+    passes.push_back(NULL);
+    if(!opts_.allocated.empty())
+      {
+        rv = l::allocated_ranges(blkdev_,opts_.allocated,ctx.stepping,allocated);
+        if(rv < 0)
+          return AppError::runtime(-rv,"unable to map allocated blocks of " + opts_.allocated);
+
+        passes[0] = &allocated;
+        if(opts_.allocated_first)
+          {
+            l::unallocated_ranges(allocated,ctx.start_block,ctx.end_block,unallocated);
+            passes.push_back(&unallocated);
+          }
+        else
+          {
+            total_blocks = allocated.count(ctx.start_block,ctx.end_block);
+          }
+      }
+
+    if(blkdev_.zoned() || blkdev_.regular_file())
+      {
+        if(opts_.sample)
+          return AppError::argument_invalid("sampling is not supported on zoned devices or files");
+
+        if(blkdev_.zoned())
+          {
+            rv = l::written_ranges(blkdev_,zones,readable);
+            if(rv < 0)
+              return AppError::runtime(-rv,"unable to report zones");
+          }
+        else
+          {
+            rv = l::data_ranges(blkdev_,ctx.stepping,readable);
+            if(rv < 0)
+              return AppError::runtime(-rv,"unable to find data in file");
+          }
+
+        total_blocks = 0;
+        limited.resize(passes.size());
+        for(size_t i = 0; i < passes.size(); i++)
+          {
+            limited[i]    = (passes[i] ? passes[i]->intersection(readable) : readable);
+            passes[i]     = &limited[i];
+            total_blocks += limited[i].count(ctx.start_block,ctx.end_block);
+          }
+      }
+
+    /*
+      A checkpoint only records how far through the range the scan got
+      which can't describe being part way through a second pass.
+    */
+    ctx.checkpoint = NULL;
+    if(!checkpoint_file_.empty() &&
+       opts_.checkpoint_interval &&
+       (passes.size() == 1) &&
+       (opts_.sample == 0))
+      {
+        checkpoint.captcha     = captcha::calculate(blkdev_);
+        checkpoint.start_block = (resume_ ? resume_->start_block : ctx.start_block);
+        checkpoint.end_block   = ctx.end_block;
+        checkpoint.stepping    = ctx.stepping;
+
+        ctx.checkpoint      = &checkpoint;
+        ctx.checkpoint_file = checkpoint_file_;
+        ctx.checkpoint_time = (Time::get_monotonic() + opts_.checkpoint_interval);
+      }
+
+    pthread_mutex_lock(&status_.mutex);
+    status_.start_time  = Time::get_monotonic();
+    status_.start_block = ctx.start_block;
+    status_.end_block   = ctx.end_block;
+    status_.current     = ctx.start_block;
+    status_.badcount    = badblocks_.size();
+    pthread_mutex_unlock(&status_.mutex);
+
+    if(verbose_)
+      {
+        if(resume_)
+          std::cout << "resuming from block: "
+                    << resume_->current_block
+                    << " (" << (uint64_t)resume_->elapsed << "s elapsed)"
+                    << std::endl;
+        std::cout << "start block: "
+                  << ctx.start_block << std::endl
+                  << "end block: "
+                  << ctx.end_block << std::endl
+                  << "stepping: "
+                  << ctx.stepping;
+        if(opts_.adaptive)
+          std::cout << " - " << ctx.max_stepping << " (adaptive)";
+        std::cout << std::endl
+                  << "logical block size: "
+                  << blkdev_.logical_block_size() << std::endl
+                  << "physical block size: "
+                  << blkdev_.physical_block_size() << std::endl
+                  << "read size: "
+                  << ctx.max_stepping << " blocks / "
+                  << ctx.buflen << " bytes"
+                  << std::endl
+                  << "queue depth: "
+                  << opts_.queue_depth << std::endl
+                  << "threads: "
+                  << opts_.threads << std::endl;
+        if(!opts_.allocated.empty())
+          std::cout << "allocated: "
+                    << allocated.count(ctx.start_block,ctx.end_block)
+                    << " blocks in "
+                    << allocated.size()
+                    << " ranges"
+                    << (opts_.allocated_first ? " (scanned first)" : "")
+                    << std::endl;
+        if(blkdev_.zoned())
+          std::cout << "zones: "
+                    << zones.size()
+                    << " of "
+                    << blkdev_.zone_blocks()
+                    << " blocks, "
+                    << readable.count(ctx.start_block,ctx.end_block)
+                    << " blocks written"
+                    << std::endl;
+        if(blkdev_.regular_file())
+          std::cout << "data: "
+                    << readable.count(ctx.start_block,ctx.end_block)
+                    << " blocks in "
+                    << readable.size()
+                    << " ranges"
+                    << std::endl;
+
+        signals::alarm(1);
+
+        std::cout << "\r\x1B[2KScanning: "
+                  << ctx.start_block
+                  << " - "
+                  << ctx.end_block
+                  << std::endl;
+
+        info.init(ctx.start_block,ctx.end_block,&badblocks_);
+        info.set_total(total_blocks);
+      }
+
+    aio = false;
+    if(opts_.queue_depth > 1)
+      {
+        rv = blkdev_.aio_init(opts_.queue_depth);
+        if((rv < 0) && verbose_)
+          std::cout << "io_uring unavailable ("
+                    << Error::to_string(-rv)
+                    << "): using synchronous reads"
+                    << std::endl;
+        aio = (rv >= 0);
+      }
+
+    if(opts_.threads > 1)
+      rv = pool.init(ctx.buflen,opts_.threads);
+    else if(aio)
+      rv = pool.init(ctx.buflen,opts_.queue_depth);
+    else
+      rv = pool.init(ctx.buflen,1);
+    if(rv < 0)
+      return AppError::runtime(-rv,"unable to allocate buffers");
+
+    buf = NULL;
+    if(aio)
+      {
+        slots.resize(opts_.queue_depth);
+        for(size_t i = 0; i < slots.size(); i++)
+          {
+            slots[i].buf  = pool.get();
+            slots[i].busy = false;
+          }
+      }
+    else if(opts_.threads <= 1)
+      {
+        buf = pool.get();
+      }
+
+    /*
+      With --allocated-first the unallocated ranges are a second pass
+      which only starts once the first has completed.
+    */
+    for(size_t i = 0; i < passes.size(); i++)
+      {
+        ctx.include = passes[i];
+        ctx.skipped = 0;
+
+        if(opts_.sample)
+          rv = l::scan_sample(ctx,buf,sample);
+        else if(opts_.threads > 1)
+          rv = l::scan_threaded(ctx,pool);
+        else if(aio)
+          rv = l::scan_loop_async(ctx,slots);
+        else
+          rv = l::scan_loop(ctx,buf);
+
+        if((rv < 0) || (status_.current < ctx.end_block))
+          break;
+
+        pthread_mutex_lock(&status_.mutex);
+        ctx.processed_base = status_.processed;
+        pthread_mutex_unlock(&status_.mutex);
+      }
+
+    if(verbose_)
+      std::cout << std::endl;
+
+    if(opts_.sample && verbose_)
+      l::print_sample(sample);
+
+    if(ctx.checkpoint)
+      {
+        if(status_.current >= ctx.end_block)
+          Checkpoint::remove(ctx.checkpoint_file);
+        else if((l::write_checkpoint(ctx,status_.current,badblocks_) == 0) && verbose_)
+          std::cout << "Checkpoint written to: " << ctx.checkpoint_file << std::endl;
+      }
 
     if(rv < 0)
       return AppError::runtime(-rv,"error when scanning drive");
@@ -184,62 +1988,379 @@ namespace l
 
   static
   void
-  set_blkdev_rwtype(BlkDev                &blkdev,
-                    const Options::RWType  rwtype)
+  print_latency(const Histogram &histogram_)
   {
-    switch(rwtype)
+    if(histogram_.count() == 0)
+      return;
+
+    std::cout << std::fixed
+              << std::setprecision(3)
+              << "read latency (ms): p50: "
+              << (histogram_.percentile(50.0) / 1000.0)
+              << "; p99: "
+              << (histogram_.percentile(99.0) / 1000.0)
+              << "; p99.9: "
+              << (histogram_.percentile(99.9) / 1000.0)
+              << "; max: "
+              << (histogram_.max() / 1000.0)
+              << "; reads: "
+              << histogram_.count()
+              << std::endl;
+  }
+
+  struct SavedERC
+  {
+    bool     saved;
+    uint16_t read;
+    uint16_t write;
+  };
+
+  static
+  void
+  print_erc(const uint16_t deciseconds_)
+  {
+    if(deciseconds_ == 0)
+      std::cout << "unlimited";
+    else
+      std::cout << (deciseconds_ / 10) << '.' << (deciseconds_ % 10) << 's';
+  }
+
+  /*
+    Cap the drive's internal error recovery so a bad sector fails in
+    about `deciseconds_` instead of the drive retrying it past the
+    command timeout and getting the link reset. The prior values are
+    kept so they can be put back once done.
+  */
+  static
+  int
+  limit_erc(BlkDev         &blkdev_,
+            const uint16_t  deciseconds_,
+            SavedERC       &saved_)
+  {
+    int rv;
+
+    saved_.saved = false;
+    if(!blkdev_.has_identity() || !blkdev_.identity().sct_erc_supported)
+      return -ENOTSUP;
+
+    rv = blkdev_.erc_get(&saved_.read,&saved_.write);
+    if(rv < 0)
+      return rv;
+
+    rv = blkdev_.erc_set(deciseconds_,deciseconds_);
+    if(rv < 0)
       {
-      case Options::ATA:
-        blkdev.set_rw_ata();
-        break;
-      case Options::OS:
-        blkdev.set_rw_os();
-        break;
+        blkdev_.erc_set(saved_.read,saved_.write);
+        return rv;
       }
+
+    saved_.saved = true;
+
+    return 0;
   }
 
   static
   AppError
-  scan(const Options &opts_)
+  scan_device(const Options     &opts_,
+              const std::string &device_,
+              ScanStatus        &status_,
+              std::string       &output_file_,
+              const bool         verbose_)
   {
     int rv;
     AppError err;
     BlkDev blkdev;
+    RateLimiter limiter;
+    SavedERC erc;
+    ScanLatency latency;
+    ScanCheckpoint resume;
     std::string input_file;
-    std::string output_file;
+    std::string slow_file;
+    std::string checkpoint_file;
     std::vector<uint64_t> badblocks;
 
-    input_file  = opts_.input_file;
-    output_file = opts_.output_file;
+    input_file   = opts_.input_file;
+    output_file_ = opts_.output_file;
+    latency.slow_usec = (opts_.slow_threshold * 1000);
 
-    rv = blkdev.open_read(opts_.device);
+    blkdev.set_file_block_size(l::file_block_size(opts_));
+    rv = blkdev.open_read(device_);
     if(rv < 0)
-      return AppError::opening_device(-rv,opts_.device);
+      return AppError::opening_device(-rv,device_);
+    if(blkdev.regular_file() && (opts_.rwtype != Options::OS))
+      return AppError::argument_invalid("regular files can only be scanned with rwtype 'os'");
     l::set_blkdev_rwtype(blkdev,opts_.rwtype);
 
-    if(output_file.empty())
-      output_file = BadBlockFile::filepath(blkdev);
+    limiter.set(opts_.max_rate * 1000000,opts_.max_iops);
+    if(limiter.enabled())
+      blkdev.set_rate_limiter(&limiter);
+
+    if(opts_.direct)
+      {
+        rv = blkdev.set_direct_io(true);
+        if(rv < 0)
+          return AppError::opening_device(-rv,device_);
+      }
+
+    if(output_file_.empty())
+      output_file_ = BadBlockFile::filepath(blkdev);
     if(input_file.empty())
-      input_file = output_file;
+      input_file = output_file_;
+
+    if(output_file_ != "-")
+      checkpoint_file = Checkpoint::filepath(output_file_);
+
+    if(opts_.resume)
+      {
+        rv = Checkpoint::read(checkpoint_file,resume);
+        if(rv < 0)
+          return AppError::opening_file(-rv,checkpoint_file);
+        if(resume.captcha != captcha::calculate(blkdev))
+          return AppError::argument_invalid("checkpoint is for a different device");
+
+        badblocks = resume.badblocks;
+      }
+    else
+      {
+        rv = BadBlockFile::read(input_file,badblocks);
+        if((rv > 0) && verbose_)
+          std::cout << "Imported bad blocks from: " << input_file << std::endl;
+      }
+
+    /*
+      Only once nothing else can fail so the original values are
+      always put back below.
+    */
+    erc.saved = false;
+    if(opts_.erc)
+      {
+        rv = l::limit_erc(blkdev,opts_.erc,erc);
+        if((rv < 0) && verbose_)
+          std::cout << "Warning: unable to set error recovery control ("
+                    << Error::to_string(-rv)
+                    << ")" << std::endl;
+        else if(verbose_)
+          {
+            std::cout << "error recovery control: read: ";
+            l::print_erc(erc.read);
+            std::cout << "; write: ";
+            l::print_erc(erc.write);
+            std::cout << " -> ";
+            l::print_erc(opts_.erc);
+            std::cout << std::endl;
+          }
+      }
+
+    err = l::scan(blkdev,
+                  device_,
+                  opts_,
+                  badblocks,
+                  latency,
+                  status_,
+                  (opts_.resume ? &resume : NULL),
+                  checkpoint_file,
+                  verbose_);
+
+    std::sort(badblocks.begin(),badblocks.end());
+    badblocks.erase(std::unique(badblocks.begin(),badblocks.end()),
+                    badblocks.end());
 
-    rv = BadBlockFile::read(input_file,badblocks);
-    if(rv > 0)
-      std::cout << "Imported bad blocks from: " << input_file << std::endl;
+    pthread_mutex_lock(&status_.mutex);
+    status_.badcount = badblocks.size();
+    pthread_mutex_unlock(&status_.mutex);
 
-    err = l::scan(blkdev,opts_,badblocks);
+    if(verbose_)
+      l::print_latency(latency.histogram);
 
-    rv = BadBlockFile::write(output_file,badblocks);
+    rv = BadBlockFile::write(output_file_,badblocks);
     if((rv < 0) && err.succeeded())
-      err = AppError::writing_badblocks_file(-rv,output_file);
-    else if(!badblocks.empty())
-      std::cout << "Bad blocks written to: " << output_file << std::endl;
+      err = AppError::writing_badblocks_file(-rv,output_file_);
+    else if(!badblocks.empty() && verbose_)
+      std::cout << "Bad blocks written to: " << output_file_ << std::endl;
+
+    if(!latency.slowblocks.empty())
+      {
+        slow_file = BadBlockFile::slow_filepath(output_file_);
+        rv = BadBlockFile::write_slow(slow_file,latency.slowblocks);
+        if((rv < 0) && err.succeeded())
+          err = AppError::writing_badblocks_file(-rv,slow_file);
+        else if(verbose_)
+          std::cout << "Slow blocks written to: " << slow_file << std::endl;
+      }
+
+    if(erc.saved)
+      {
+        rv = blkdev.erc_set(erc.read,erc.write);
+        if((rv < 0) && err.succeeded())
+          err = AppError::runtime(-rv,"unable to restore error recovery control");
+      }
 
     rv = blkdev.close();
     if((rv < 0) && err.succeeded())
-      err = AppError::closing_device(-rv,opts_.device);
+      err = AppError::closing_device(-rv,device_);
+
+    return err;
+  }
+
+  struct DeviceScan
+  {
+    pthread_t      thread;
+    const Options *opts;
+    std::string    device;
+    std::string    output_file;
+    ScanStatus     status;
+    AppError       err;
+  };
+
+  static
+  void*
+  scan_device_thread(void *data_)
+  {
+    DeviceScan *d = (DeviceScan*)data_;
+
+    d->err = l::scan_device(*d->opts,d->device,d->status,d->output_file,false);
+
+    pthread_mutex_lock(&d->status.mutex);
+    d->status.done = true;
+    pthread_mutex_unlock(&d->status.mutex);
+
+    return NULL;
+  }
+
+  static
+  void
+  print_table(InfoTable                      &table_,
+              const std::vector<DeviceScan*> &scans_)
+  {
+    std::vector<InfoTableRow> rows(scans_.size());
+
+    for(size_t i = 0; i < scans_.size(); i++)
+      {
+        DeviceScan   *d   = scans_[i];
+        InfoTableRow &row = rows[i];
+
+        pthread_mutex_lock(&d->status.mutex);
+        row.name             = d->device;
+        row.start_time       = d->status.start_time;
+        row.start_block      = d->status.start_block;
+        row.end_block        = d->status.end_block;
+        row.current_block    = d->status.current;
+        row.processed_blocks = d->status.processed;
+        row.badcount         = d->status.badcount;
+        row.done             = d->status.done;
+        row.failed           = (d->status.done && !d->err.succeeded());
+        pthread_mutex_unlock(&d->status.mutex);
+      }
+
+    table_.print(rows);
+  }
+
+  static
+  size_t
+  count_done(const std::vector<DeviceScan*> &scans_)
+  {
+    size_t rv;
+
+    rv = 0;
+    for(size_t i = 0; i < scans_.size(); i++)
+      {
+        pthread_mutex_lock(&scans_[i]->status.mutex);
+        rv += scans_[i]->status.done;
+        pthread_mutex_unlock(&scans_[i]->status.mutex);
+      }
+
+    return rv;
+  }
+
+  /*
+    Scan a number of devices concurrently: one thread per device each
+    with its own BlkDev, status, and bad block file. The main thread
+    only prints a single table of every device's progress.
+  */
+  static
+  AppError
+  scan_devices(const Options &opts_)
+  {
+    int rv;
+    AppError err;
+    InfoTable table;
+    std::vector<DeviceScan*> scans;
+
+    for(size_t i = 0; i < opts_.devices.size(); i++)
+      {
+        DeviceScan *d = new DeviceScan();
+
+        d->opts   = &opts_;
+        d->device = opts_.devices[i];
+        l::init_status(d->status);
+
+        rv = l::spawn_thread(&d->thread,l::scan_device_thread,d);
+        if(rv < 0)
+          {
+            delete d;
+            err = AppError::runtime(-rv,"unable to spawn scan thread");
+            break;
+          }
+
+        scans.push_back(d);
+      }
+
+    std::cout << "Scanning " << scans.size() << " devices" << std::endl;
+
+    table.init();
+    signals::alarm(1);
+    while(l::count_done(scans) != scans.size())
+      {
+        if(signals::dec(SIGALRM))
+          {
+            signals::alarm(1);
+            l::print_table(table,scans);
+          }
+
+        ::usleep(100 * 1000);
+      }
+
+    l::print_table(table,scans);
+    std::cout << std::endl;
+
+    for(size_t i = 0; i < scans.size(); i++)
+      {
+        DeviceScan *d = scans[i];
+
+        pthread_join(d->thread,NULL);
+
+        std::cout << d->device << ": ";
+        if(d->err.succeeded())
+          std::cout << d->status.badcount
+                    << " bad blocks; written to: "
+                    << d->output_file;
+        else
+          std::cout << d->err.to_string();
+        std::cout << std::endl;
+
+        if(err.succeeded() && !d->err.succeeded())
+          err = d->err;
+
+        delete d;
+      }
 
     return err;
   }
+
+  static
+  AppError
+  scan(const Options &opts_)
+  {
+    ScanStatus status;
+    std::string output_file;
+
+    if(opts_.devices.size() > 1)
+      return l::scan_devices(opts_);
+
+    l::init_status(status);
+
+    return l::scan_device(opts_,opts_.device,status,output_file,true);
+  }
 }
 
 namespace bbf
@@ -19,6 +19,7 @@
 #include "blkdev.hpp"
 #include "ioctl.hpp"
 
+#include <algorithm>
 #include <string>
 
 #include <errno.h>
@@ -26,15 +27,23 @@
 #include <stdint.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #define SECONDS(x) ((x) * 1000)
 
+SimDev *BlkDev::_simulated = NULL;
+
 namespace l
 {
+  /*
+    Returns 0 for a block device, 1 for a regular file when those are
+    allowed.
+  */
   static
   int
-  block_device(const int fd_)
+  block_device(const int  fd_,
+               const bool allow_file_)
   {
     int rv;
     struct stat st;
@@ -43,11 +52,71 @@ namespace l
     if(rv == -1)
       return -errno;
 
+    if(S_ISREG(st.st_mode) && allow_file_)
+      return 1;
     if(!S_ISBLK(st.st_mode))
       return -ENOTBLK;
 
     return 0;
   }
+
+  /*
+    Regular files have no device geometry so `block_size_` is used for
+    both. A trailing partial block is ignored.
+  */
+  static
+  int
+  file_geometry(const int       fd_,
+                const uint64_t  block_size_,
+                uint64_t       *lbs_,
+                uint64_t       *pbs_,
+                uint64_t       *size_)
+  {
+    int rv;
+    struct stat st;
+
+    rv = ::fstat(fd_,&st);
+    if(rv == -1)
+      return -errno;
+
+    *lbs_  = block_size_;
+    *pbs_  = block_size_;
+    *size_ = (((uint64_t)st.st_size / block_size_) * block_size_);
+
+    return 0;
+  }
+
+  /*
+    RWF_DSYNC makes the write its own sync which the block layer turns
+    into a FUA write, or a write and flush if the device lacks FUA.
+    Kernels without pwritev2 get the write and a flush.
+  */
+  static
+  int64_t
+  pwrite_dsync(const int       fd_,
+               const void     *buf_,
+               const uint64_t  len_,
+               const off_t     offset_,
+               const uint64_t  lbs_)
+  {
+    int64_t rv;
+    struct iovec iov;
+
+    iov.iov_base = (void*)buf_;
+    iov.iov_len  = len_;
+
+    rv = ::pwritev2(fd_,&iov,1,offset_,RWF_DSYNC);
+    if((rv == -1) && ((errno == ENOSYS) || (errno == EOPNOTSUPP)))
+      {
+        rv = ::pwrite(fd_,buf_,len_,offset_);
+        if((rv != -1) && (::fdatasync(fd_) == -1))
+          rv = -1;
+      }
+    if(rv == -1)
+      return -errno;
+
+    return (rv / lbs_);
+  }
 }
 
 void
@@ -59,12 +128,19 @@ BlkDev::_reset_data(void)
   _size_in_bytes        =  0;
   _logical_block_count  =  0;
   _physical_block_count =  0;
+  _zone_blocks          =  0;
+  _regular_file         =  false;
+  _sim                  =  NULL;
   _timeout              =  SECONDS(10);
   _has_identity         =  false;
 }
 
 BlkDev::BlkDev()
-  : _rw_type(OS)
+  : _rw_type(OS),
+    _file_block_size(0),
+    _fua(false),
+    _limiter(NULL),
+    _throttled(0)
 {
   _reset_data();
 }
@@ -100,14 +176,50 @@ BlkDev::open(const std::string &path,
 {
   int64_t rv;
 
+  /*
+    Every device opened while simulating is the simulated device.
+    There's no fd so anything needing one fails with EBADF.
+  */
+  if(_simulated)
+    {
+      _sim                  = _simulated;
+      _rw_type              = SIM;
+      _logical_block_size   = _sim->spec().logical_block_size;
+      _physical_block_size  = _sim->spec().physical_block_size;
+      _size_in_bytes        = _sim->spec().size;
+      _logical_block_count  = (_size_in_bytes / _logical_block_size);
+      _physical_block_count = (_size_in_bytes / _physical_block_size);
+
+      return 0;
+    }
+
   _fd = ::open(path.c_str(),flags);
   if(_fd == -1)
     return -errno;
 
-  rv = l::block_device(_fd);
+  rv = l::block_device(_fd,(_file_block_size != 0));
   if(rv < 0)
     goto error;
 
+  if(rv == 1)
+    {
+      rv = l::file_geometry(_fd,
+                            _file_block_size,
+                            &_logical_block_size,
+                            &_physical_block_size,
+                            &_size_in_bytes);
+      if(rv < 0)
+        goto error;
+
+      _regular_file         = true;
+      _logical_block_count  = (_size_in_bytes / _logical_block_size);
+      _physical_block_count = (_size_in_bytes / _physical_block_size);
+
+      ::posix_fadvise(_fd,0,_size_in_bytes,POSIX_FADV_DONTNEED);
+
+      return 0;
+    }
+
   rv = sg::identify(_fd,_identity);
   if(rv == 0)
     _has_identity = true;
@@ -130,6 +242,10 @@ BlkDev::open(const std::string &path,
   _logical_block_count  = (_size_in_bytes / _logical_block_size);
   _physical_block_count = (_size_in_bytes / _physical_block_size);
 
+  rv = IOCtl::zone_sectors(_fd);
+  if(rv > 0)
+    _zone_blocks = ((rv * 512) / _logical_block_size);
+
   ::posix_fadvise(_fd,0,_size_in_bytes,POSIX_FADV_DONTNEED);
 
   return 0;
@@ -147,9 +263,18 @@ BlkDev::close(void)
 {
   int rv;
 
+  if(_sim)
+    {
+      _sim_done.clear();
+      _reset_data();
+      return 0;
+    }
+
   if(_fd == -1)
     return 0;
 
+  _ring.destroy();
+
   rv = ::close(_fd);
 
   _reset_data();
@@ -157,6 +282,31 @@ BlkDev::close(void)
   return ((rv == -1) ? -errno : rv);
 }
 
+/*
+  O_DIRECT reads and writes bypass the page cache entirely. Buffers
+  and lengths must be aligned to the logical block size which
+  BufferPool guarantees.
+*/
+int
+BlkDev::set_direct_io(const bool enable_)
+{
+  int rv;
+  int flags;
+
+  if(_sim)
+    return 0;
+
+  flags = ::fcntl(_fd,F_GETFL);
+  if(flags == -1)
+    return -errno;
+
+  flags = (enable_ ? (flags | O_DIRECT) : (flags & ~O_DIRECT));
+
+  rv = ::fcntl(_fd,F_SETFL,flags);
+
+  return ((rv == -1) ? -errno : 0);
+}
+
 int64_t
 BlkDev::os_read(const uint64_t  lba_,
                 const uint64_t  blocks_,
@@ -192,6 +342,9 @@ BlkDev::os_write(const uint64_t  lba_,
   len    = std::min((blocks_ * _logical_block_size),len);
   offset = (lba_ * _logical_block_size);
 
+  if(_fua)
+    return l::pwrite_dsync(_fd,buf_,len,offset,_logical_block_size);
+
   rv = ::pwrite(_fd,buf_,len,offset);
   if(rv == -1)
     return -errno;
@@ -212,6 +365,7 @@ BlkDev::ata_read(const uint64_t  lba_,
                       blocks_,
                       buf_,
                       buflen_,
+                      ((_rw_type == ATA_PIO) ? SG_PIO : SG_DMA),
                       _timeout);
   if(rv < 0)
     return rv;
@@ -232,25 +386,133 @@ BlkDev::ata_write(const uint64_t  lba_,
                        blocks_,
                        buf_,
                        buflen_,
+                       ((_rw_type == ATA_PIO) ? SG_PIO : SG_DMA),
+                       _fua,
                        _timeout);
   if(rv < 0)
     return rv;
 
+  if(_fua && (_rw_type == ATA_PIO))
+    {
+      rv = sg::flush_write_cache(_fd,_timeout);
+      if(rv < 0)
+        return rv;
+    }
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::ata_verify(const uint64_t lba_,
+                   const uint64_t blocks_)
+{
+  int rv;
+
+  rv = sg::verify_block(_fd,
+                        lba_,
+                        blocks_,
+                        _timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_read(const uint64_t  lba_,
+                  const uint64_t  blocks_,
+                  void           *buf_,
+                  const uint64_t  buflen_)
+{
+  int rv;
+
+  rv = sg::scsi_read_block(_fd,
+                           lba_,
+                           blocks_,
+                           buf_,
+                           buflen_,
+                           _fua,
+                           _timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_write(const uint64_t  lba_,
+                   const uint64_t  blocks_,
+                   const void     *buf_,
+                   const uint64_t  buflen_)
+{
+  int rv;
+
+  rv = sg::scsi_write_block(_fd,
+                            lba_,
+                            blocks_,
+                            buf_,
+                            buflen_,
+                            _fua,
+                            _timeout);
+  if(rv < 0)
+    return rv;
+
+  return blocks_;
+}
+
+int64_t
+BlkDev::scsi_verify(const uint64_t lba_,
+                    const uint64_t blocks_)
+{
+  int rv;
+
+  rv = sg::scsi_verify_block(_fd,
+                             lba_,
+                             blocks_,
+                             _timeout);
+  if(rv < 0)
+    return rv;
+
   return blocks_;
 }
 
+/*
+  Every read and write goes through here so a rate limit applies no
+  matter how the I/O is issued. Time spent waiting is tallied so that
+  callers timing requests can leave it out.
+*/
+void
+BlkDev::_throttle(const uint64_t blocks_)
+{
+  if(_limiter == NULL)
+    return;
+
+  _throttled += _limiter->acquire(blocks_ * _logical_block_size);
+}
+
 int64_t
 BlkDev::read(const uint64_t  lba_,
              const uint64_t  blocks_,
              void           *buf_,
              const uint64_t  buflen_)
 {
+  _throttle(blocks_);
+
   switch(_rw_type)
     {
     case ATA:
+    case ATA_PIO:
       return ata_read(lba_,blocks_,buf_,buflen_);
     case OS:
       return os_read(lba_,blocks_,buf_,buflen_);
+    case VERIFY:
+      return ata_verify(lba_,blocks_);
+    case SCSI:
+      return scsi_read(lba_,blocks_,buf_,buflen_);
+    case SCSI_VERIFY:
+      return scsi_verify(lba_,blocks_);
+    case SIM:
+      return _sim->read(lba_,blocks_,buf_,buflen_);
     }
 
   return -ENOTSUP;
@@ -261,12 +523,23 @@ BlkDev::read(const uint64_t     lba_,
              const uint64_t     blocks_,
              std::vector<char> &buf_)
 {
+  _throttle(blocks_);
+
   switch(_rw_type)
     {
     case ATA:
+    case ATA_PIO:
       return ata_read(lba_,blocks_,&buf_[0],buf_.size());
     case OS:
       return os_read(lba_,blocks_,&buf_[0],buf_.size());
+    case VERIFY:
+      return ata_verify(lba_,blocks_);
+    case SCSI:
+      return scsi_read(lba_,blocks_,&buf_[0],buf_.size());
+    case SCSI_VERIFY:
+      return scsi_verify(lba_,blocks_);
+    case SIM:
+      return _sim->read(lba_,blocks_,&buf_[0],buf_.size());
     }
 
   return -ENOTSUP;
@@ -278,12 +551,22 @@ BlkDev::write(const uint64_t  lba_,
               const void     *buf_,
               const uint64_t  buflen_)
 {
+  _throttle(blocks_);
+
   switch(_rw_type)
     {
     case ATA:
+    case ATA_PIO:
       return ata_write(lba_,blocks_,buf_,buflen_);
+    case SCSI:
+      return scsi_write(lba_,blocks_,buf_,buflen_);
     case OS:
       return os_write(lba_,blocks_,buf_,buflen_);
+    case VERIFY:
+    case SCSI_VERIFY:
+      return -ENOTSUP;
+    case SIM:
+      return _sim->write(lba_,blocks_,buf_,buflen_);
     }
 
   return -ENOTSUP;
@@ -294,23 +577,163 @@ BlkDev::write(const uint64_t           lba_,
               const uint64_t           blocks_,
               const std::vector<char> &buf_)
 {
+  _throttle(blocks_);
+
   switch(_rw_type)
     {
     case ATA:
+    case ATA_PIO:
       return ata_write(lba_,blocks_,&buf_[0],buf_.size());
+    case SCSI:
+      return scsi_write(lba_,blocks_,&buf_[0],buf_.size());
     case OS:
       return os_write(lba_,blocks_,&buf_[0],buf_.size());
+    case VERIFY:
+    case SCSI_VERIFY:
+      return -ENOTSUP;
+    case SIM:
+      return _sim->write(lba_,blocks_,&buf_[0],buf_.size());
     }
 
   return -ENOTSUP;
 }
 
+/*
+  The simulated device completes reads as they're queued and hands
+  the results back in order.
+*/
+int
+BlkDev::aio_init(const unsigned depth_)
+{
+  if(_sim)
+    return 0;
+  if(_ring.initialized())
+    return 0;
+
+  return _ring.init(depth_);
+}
+
+int
+BlkDev::aio_read(const uint64_t  lba_,
+                 const uint64_t  blocks_,
+                 void           *buf_,
+                 const uint64_t  buflen_,
+                 const uint64_t  tag_)
+{
+  uint64_t len;
+  off_t offset;
+
+  len    = std::min((blocks_ * _logical_block_size),buflen_);
+  offset = (lba_ * _logical_block_size);
+
+  _throttle(blocks_);
+
+  if(_sim)
+    {
+      _sim_done.push_back(std::make_pair(tag_,_sim->read(lba_,blocks_,buf_,buflen_)));
+      return 0;
+    }
+
+  return _ring.prep_read(_fd,buf_,len,offset,tag_);
+}
+
+int
+BlkDev::aio_write(const uint64_t  lba_,
+                  const uint64_t  blocks_,
+                  const void     *buf_,
+                  const uint64_t  buflen_,
+                  const uint64_t  tag_)
+{
+  uint64_t len;
+  off_t offset;
+
+  len    = std::min((blocks_ * _logical_block_size),buflen_);
+  offset = (lba_ * _logical_block_size);
+
+  _throttle(blocks_);
+
+  if(_sim)
+    {
+      _sim_done.push_back(std::make_pair(tag_,_sim->write(lba_,blocks_,buf_,buflen_)));
+      return 0;
+    }
+
+  return _ring.prep_write(_fd,buf_,len,offset,(_fua ? RWF_DSYNC : 0),tag_);
+}
+
+int
+BlkDev::aio_submit(void)
+{
+  int rv;
+
+  if(_sim)
+    return 0;
+
+  rv = _ring.submit();
+
+  return ((rv < 0) ? rv : 0);
+}
+
+/*
+  On completion `blocks` holds the same value `os_read` or `os_write`
+  would have returned for the request: blocks transferred or -errno.
+*/
+int
+BlkDev::aio_wait(uint64_t *tag_,
+                 int64_t  *blocks_)
+{
+  int rv;
+  int32_t res;
+
+  if(_sim)
+    {
+      if(_sim_done.empty())
+        return -EAGAIN;
+
+      *tag_    = _sim_done.front().first;
+      *blocks_ = _sim_done.front().second;
+      _sim_done.pop_front();
+
+      return 0;
+    }
+
+  rv = _ring.wait(tag_,&res);
+  if(rv < 0)
+    return rv;
+
+  *blocks_ = ((res < 0) ? res : (res / (int64_t)_logical_block_size));
+
+  return 0;
+}
+
 uint64_t
 BlkDev::block_stepping(void) const
 {
   return (_physical_block_size / _logical_block_size);
 }
 
+/*
+  Largest number of logical blocks worth issuing in a single request.
+  Bounded by the queue's max_sectors and the 16bit ATA sector count.
+*/
+uint64_t
+BlkDev::max_transfer_blocks(void) const
+{
+  int rv;
+  uint64_t blocks;
+
+  rv = IOCtl::max_sectors(_fd);
+  if(rv <= 0)
+    blocks = ((1024 * 1024) / _logical_block_size);
+  else
+    blocks = (((uint64_t)rv * 512) / _logical_block_size);
+
+  blocks = std::min(blocks,(uint64_t)65536);
+  blocks = std::max(blocks,block_stepping());
+
+  return blocks;
+}
+
 int
 BlkDev::sync(void)
 {
@@ -318,6 +741,8 @@ BlkDev::sync(void)
   int error;
 
   error = 0;
+  if(_sim)
+    return 0;
 
   rv = ::fsync(_fd);
   if(rv == -1)
@@ -338,6 +763,12 @@ int
 BlkDev::write_flagged_uncorrectable(const uint64_t lba_,
                                     const bool     log_)
 {
+  if(_sim)
+    {
+      _sim->mark_bad(lba_);
+      return 0;
+    }
+
   return sg::write_flagged_uncorrectable(_fd,lba_,log_,_timeout);
 }
 
@@ -345,5 +776,115 @@ int
 BlkDev::write_pseudo_uncorrectable(const uint64_t lba_,
                                    const bool     log_)
 {
+  if(_sim)
+    {
+      _sim->mark_bad(lba_);
+      return 0;
+    }
+
   return sg::write_pseudo_uncorrectable(_fd,lba_,log_,_timeout);
 }
+
+/*
+  SCT Error Recovery Control time limits in 100ms units.
+*/
+int
+BlkDev::erc_get(uint16_t *read_ds_,
+                uint16_t *write_ds_)
+{
+  int rv;
+
+  rv = sg::sct_erc_get(_fd,sg::SCT_ERC_READ,read_ds_,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return sg::sct_erc_get(_fd,sg::SCT_ERC_WRITE,write_ds_,_timeout);
+}
+
+int
+BlkDev::erc_set(const uint16_t read_ds_,
+                const uint16_t write_ds_)
+{
+  int rv;
+
+  rv = sg::sct_erc_set(_fd,sg::SCT_ERC_READ,read_ds_,_timeout);
+  if(rv < 0)
+    return rv;
+
+  return sg::sct_erc_set(_fd,sg::SCT_ERC_WRITE,write_ds_,_timeout);
+}
+
+/*
+  Zones are reported in 512 byte sectors regardless of the logical
+  block size. Older kernels don't report zone capacity in which case
+  it is the zone length.
+*/
+int
+BlkDev::report_zones(std::vector<Zone> &zones_)
+{
+  int rv;
+  uint64_t sector;
+  uint64_t sectors;
+  uint64_t spb;
+  std::vector<char> buf;
+  struct blk_zone_report *report;
+  const uint32_t batch = 1024;
+
+  zones_.clear();
+  if(!zoned())
+    return 0;
+
+  buf.resize(sizeof(struct blk_zone_report) +
+             (batch * sizeof(struct blk_zone)));
+  report = (struct blk_zone_report*)&buf[0];
+
+  spb     = (_logical_block_size / 512);
+  sectors = (_size_in_bytes / 512);
+  sector  = 0;
+  while(sector < sectors)
+    {
+      report->sector   = sector;
+      report->nr_zones = batch;
+      report->flags    = 0;
+
+      rv = IOCtl::report_zones(_fd,report);
+      if(rv < 0)
+        return rv;
+      if(report->nr_zones == 0)
+        break;
+
+      for(uint32_t i = 0; i < report->nr_zones; i++)
+        {
+          Zone zone;
+          const struct blk_zone &z = report->zones[i];
+
+          zone.start    = (z.start / spb);
+          zone.len      = (z.len / spb);
+          zone.capacity = ((report->flags & BLK_ZONE_REP_CAPACITY) ?
+                           (z.capacity / spb) : zone.len);
+          zone.wp       = (z.wp / spb);
+          zone.type     = z.type;
+          zone.cond     = z.cond;
+
+          zones_.push_back(zone);
+
+          sector = (z.start + z.len);
+        }
+    }
+
+  return 0;
+}
+
+/*
+  Resetting a zone discards its data and moves the write pointer back
+  to the start of the zone.
+*/
+int
+BlkDev::reset_zone(const Zone &zone_)
+{
+  uint64_t spb;
+
+  spb = (_logical_block_size / 512);
+
+  return IOCtl::reset_zones(_fd,(zone_.start * spb),(zone_.len * spb));
+}
@@ -18,23 +18,73 @@
 
 #pragma once
 
+#include "iouring.hpp"
+#include "ratelimiter.hpp"
 #include "sg.hpp"
+#include "simdev.hpp"
 
+#include <deque>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <linux/blkzoned.h>
 
 
 class BlkDev
 {
+public:
+  /*
+    Zone descriptor in logical blocks.
+  */
+  struct Zone
+  {
+    uint64_t start;
+    uint64_t len;
+    uint64_t capacity;
+    uint64_t wp;
+    uint8_t  type;
+    uint8_t  cond;
+
+    bool sequential(void) const
+    {
+      return (type != BLK_ZONE_TYPE_CONVENTIONAL);
+    }
+
+    bool writable(void) const
+    {
+      return ((cond != BLK_ZONE_COND_READONLY) &&
+              (cond != BLK_ZONE_COND_OFFLINE));
+    }
+
+    /* end of the range of blocks which hold data and can be read */
+    uint64_t readable_end(void) const
+    {
+      if(!sequential())
+        return (start + capacity);
+
+      switch(cond)
+        {
+        case BLK_ZONE_COND_OFFLINE:
+          return start;
+        case BLK_ZONE_COND_FULL:
+        case BLK_ZONE_COND_READONLY:
+          return (start + capacity);
+        default:
+          return wp;
+        }
+    }
+  };
+
 public:
   BlkDev();
   ~BlkDev();
 
 private:
   void _reset_data(void);
+  void _throttle(const uint64_t blocks);
 
 public:
   int open(const std::string &path,
@@ -43,6 +93,14 @@ public:
   int open_rdwr(const std::string &path,
                 const bool         excl = true);
   int close(void);
+  static void simulate(SimDev *sim) { _simulated = sim; }
+  int set_direct_io(const bool enable);
+  void set_fua(const bool enable) { _fua = enable; }
+  bool fua(void) const { return _fua; }
+  void set_file_block_size(const uint64_t size) { _file_block_size = size; }
+  void set_rate_limiter(RateLimiter *limiter) { _limiter = limiter; }
+  RateLimiter *rate_limiter(void) const { return _limiter; }
+  double throttled(void) const { return _throttled; }
 
 public:
   int64_t os_read(const uint64_t  lba,
@@ -65,18 +123,44 @@ public:
                     const void     *buf,
                     const uint64_t  buflen);
 
+  int64_t ata_verify(const uint64_t lba,
+                     const uint64_t blocks);
+
+  int64_t scsi_read(const uint64_t  lba,
+                    const uint64_t  blocks,
+                    void           *buf,
+                    const uint64_t  buflen);
+
+  int64_t scsi_write(const uint64_t  lba,
+                     const uint64_t  blocks,
+                     const void     *buf,
+                     const uint64_t  buflen);
+
+  int64_t scsi_verify(const uint64_t lba,
+                      const uint64_t blocks);
+
 private:
   enum RWType
     {
       ATA,
-      OS
+      ATA_PIO,
+      OS,
+      VERIFY,
+      SCSI,
+      SCSI_VERIFY,
+      SIM
     };
 
   RWType _rw_type;
 
 public:
-  void set_rw_ata(void) { _rw_type = ATA; }
-  void set_rw_os(void)  { _rw_type = OS;  }
+  void set_rw_ata(void)         { _rw_type = ATA;         }
+  void set_rw_ata_pio(void)     { _rw_type = ATA_PIO;     }
+  void set_rw_os(void)          { _rw_type = OS;          }
+  void set_rw_verify(void)      { _rw_type = VERIFY;      }
+  void set_rw_scsi(void)        { _rw_type = SCSI;        }
+  void set_rw_scsi_verify(void) { _rw_type = SCSI_VERIFY; }
+  void set_rw_sim(void)         { _rw_type = SIM;         }
   int64_t read(const uint64_t  lba,
                const uint64_t  blocks,
                void           *buf,
@@ -95,12 +179,38 @@ public:
                 const uint64_t           blocks,
                 const std::vector<char> &buf);
 
+public:
+  int aio_init(const unsigned depth);
+  int aio_read(const uint64_t  lba,
+               const uint64_t  blocks,
+               void           *buf,
+               const uint64_t  buflen,
+               const uint64_t  tag);
+  int aio_write(const uint64_t  lba,
+                const uint64_t  blocks,
+                const void     *buf,
+                const uint64_t  buflen,
+                const uint64_t  tag);
+  int aio_submit(void);
+  int aio_wait(uint64_t *tag,
+               int64_t  *blocks);
+
 public:
   int sync(void);
   int write_flagged_uncorrectable(const uint64_t lba_,
                                   const bool     log_);
   int write_pseudo_uncorrectable(const uint64_t lba_,
                                  const bool     log_);
+  int erc_get(uint16_t *read_ds,
+              uint16_t *write_ds);
+  int erc_set(const uint16_t read_ds,
+              const uint16_t write_ds);
+
+public:
+  bool zoned(void) const { return (_zone_blocks != 0); }
+  uint64_t zone_blocks(void) const { return _zone_blocks; }
+  int report_zones(std::vector<Zone> &zones);
+  int reset_zone(const Zone &zone);
 
 public:
   uint64_t logical_block_size(void) const { return _logical_block_size; }
@@ -108,7 +218,9 @@ public:
   uint64_t size_in_bytes(void) const { return _size_in_bytes; }
   uint64_t logical_block_count(void) const { return _logical_block_count; }
   uint64_t physical_block_count(void) const { return _physical_block_count; }
+  bool regular_file(void) const { return _regular_file; }
   uint64_t block_stepping(void) const;
+  uint64_t max_transfer_blocks(void) const;
 
 public:
   const bool  has_identity(void) const { return _has_identity; }
@@ -123,12 +235,27 @@ private:
   uint64_t _size_in_bytes;
   uint64_t _logical_block_count;
   uint64_t _physical_block_count;
+  uint64_t _zone_blocks;
+  uint64_t _file_block_size;
+  bool     _regular_file;
 
 private:
   sg::identity _identity;
   bool         _has_identity;
 
 private:
-  int _fd;
-  int _timeout;
+  int     _fd;
+  int     _timeout;
+  bool    _fua;
+  SimDev *_sim;
+
+  static SimDev *_simulated;
+
+private:
+  std::deque<std::pair<uint64_t,int64_t> > _sim_done;
+
+private:
+  IOURing      _ring;
+  RateLimiter *_limiter;
+  double       _throttled;
 };
@@ -0,0 +1,223 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "blockranges.hpp"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include <stdint.h>
+
+
+void
+BlockRanges::add(const uint64_t block_)
+{
+  add(block_,block_ + 1);
+}
+
+void
+BlockRanges::add(uint64_t start_,
+                 uint64_t end_)
+{
+  std::map<uint64_t,uint64_t>::iterator i;
+
+  if(start_ >= end_)
+    return;
+
+  i = _ranges.upper_bound(start_);
+  if(i != _ranges.begin())
+    {
+      std::map<uint64_t,uint64_t>::iterator prev = i;
+
+      --prev;
+      if(prev->second >= start_)
+        {
+          start_ = prev->first;
+          end_   = std::max(end_,prev->second);
+          i      = prev;
+        }
+    }
+
+  while((i != _ranges.end()) && (i->first <= end_))
+    {
+      end_ = std::max(end_,i->second);
+      _ranges.erase(i++);
+    }
+
+  _ranges[start_] = end_;
+}
+
+void
+BlockRanges::add(const std::vector<uint64_t> &blocks_)
+{
+  for(size_t i = 0; i < blocks_.size(); i++)
+    add(blocks_[i]);
+}
+
+/*
+  Drops [start_,end_) splitting any range which straddles it.
+*/
+void
+BlockRanges::remove(const uint64_t start_,
+                    const uint64_t end_)
+{
+  uint64_t end;
+  std::map<uint64_t,uint64_t>::iterator i;
+
+  if(start_ >= end_)
+    return;
+
+  i = _ranges.upper_bound(start_);
+  if(i != _ranges.begin())
+    {
+      --i;
+      if(i->second > start_)
+        {
+          end = i->second;
+          if(i->first < start_)
+            i->second = start_;
+          else
+            _ranges.erase(i);
+          if(end > end_)
+            _ranges[end_] = end;
+        }
+      i = _ranges.upper_bound(start_);
+    }
+
+  while((i != _ranges.end()) && (i->first < end_))
+    {
+      end = i->second;
+      _ranges.erase(i++);
+      if(end > end_)
+        _ranges[end_] = end;
+    }
+}
+
+void
+BlockRanges::clear(void)
+{
+  _ranges.clear();
+}
+
+/*
+  Finds the first range which contains `block_` or lies after it.
+*/
+bool
+BlockRanges::next(const uint64_t  block_,
+                  uint64_t       *start_,
+                  uint64_t       *end_) const
+{
+  std::map<uint64_t,uint64_t>::const_iterator i;
+
+  i = _ranges.upper_bound(block_);
+  if(i != _ranges.begin())
+    {
+      std::map<uint64_t,uint64_t>::const_iterator prev = i;
+
+      --prev;
+      if(prev->second > block_)
+        i = prev;
+    }
+
+  if(i == _ranges.end())
+    return false;
+
+  *start_ = i->first;
+  *end_   = i->second;
+
+  return true;
+}
+
+bool
+BlockRanges::contains(const uint64_t block_) const
+{
+  uint64_t start;
+  uint64_t end;
+
+  if(!next(block_,&start,&end))
+    return false;
+
+  return (start <= block_);
+}
+
+bool
+BlockRanges::intersects(const uint64_t start_,
+                        const uint64_t end_) const
+{
+  uint64_t start;
+  uint64_t end;
+
+  if(!next(start_,&start,&end))
+    return false;
+
+  return (start < end_);
+}
+
+/*
+  Number of blocks in [start_,end_) covered by the ranges.
+*/
+uint64_t
+BlockRanges::count(const uint64_t start_,
+                   const uint64_t end_) const
+{
+  uint64_t rv;
+  uint64_t start;
+  uint64_t end;
+  uint64_t block;
+
+  rv    = 0;
+  block = start_;
+  while((block < end_) && next(block,&start,&end))
+    {
+      start = std::max(start,block);
+      end   = std::min(end,end_);
+      if(start >= end)
+        break;
+      rv   += (end - start);
+      block = end;
+    }
+
+  return rv;
+}
+
+/*
+  Ranges covered by both this and `other_`.
+*/
+BlockRanges
+BlockRanges::intersection(const BlockRanges &other_) const
+{
+  BlockRanges rv;
+  const_iterator a;
+  const_iterator b;
+
+  a = begin();
+  b = other_.begin();
+  while((a != end()) && (b != other_.end()))
+    {
+      rv.add(std::max(a->first,b->first),
+             std::min(a->second,b->second));
+
+      if(a->second < b->second)
+        ++a;
+      else
+        ++b;
+    }
+
+  return rv;
+}
@@ -0,0 +1,64 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Sorted set of non-overlapping, non-adjacent half open block ranges
+  [start,end). Adding a range merges it with any it touches.
+*/
+
+class BlockRanges
+{
+public:
+  void add(const uint64_t block);
+  void add(const uint64_t start,
+           const uint64_t end);
+  void add(const std::vector<uint64_t> &blocks);
+  void remove(const uint64_t start,
+              const uint64_t end);
+  void clear(void);
+
+public:
+  bool   empty(void) const { return _ranges.empty(); }
+  size_t size(void) const { return _ranges.size(); }
+  bool   contains(const uint64_t block) const;
+  bool   intersects(const uint64_t start,
+                    const uint64_t end) const;
+  bool   next(const uint64_t  block,
+              uint64_t       *start,
+              uint64_t       *end) const;
+  uint64_t count(const uint64_t start,
+                 const uint64_t end) const;
+  BlockRanges intersection(const BlockRanges &other) const;
+
+public:
+  typedef std::map<uint64_t,uint64_t>::const_iterator const_iterator;
+
+  const_iterator begin(void) const { return _ranges.begin(); }
+  const_iterator end(void) const { return _ranges.end(); }
+
+private:
+  std::map<uint64_t,uint64_t> _ranges;
+};
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -91,6 +92,7 @@ get_blocks(const int                    fd,
 static
 bool
 scan(const std::string           &basepath,
+     const dev_t                  device,
      const uint64_t               blocksize,
      BlockToFileMapper::BlockMap &blockmap)
 {
@@ -109,15 +111,22 @@ scan(const std::string           &basepath,
         {
         case DT_DIR:
           {
+            struct stat st;
             std::string dirpath(basepath);
 
             if(dot_or_dot_dot(d->d_name))
               break;
 
+            // don't cross into other filesystems mounted below
+            if(::fstatat(dfd,d->d_name,&st,AT_SYMLINK_NOFOLLOW) == -1)
+              break;
+            if(st.st_dev != device)
+              break;
+
             dirpath += '/';
             dirpath += d->d_name;
 
-            scan(dirpath,blocksize,blockmap);
+            scan(dirpath,device,blocksize,blockmap);
           }
           break;
         case DT_REG:
@@ -173,13 +182,18 @@ int
 BlockToFileMapper::scan(const std::string &basepath)
 {
   int rv;
+  struct stat st;
   int64_t blocksize;
 
   blocksize = File::logical_block_size(basepath);
   if(blocksize < 0)
     return blocksize;
 
-  rv = ::scan(basepath,blocksize,_blockmap);
+  rv = ::stat(basepath.c_str(),&st);
+  if(rv == -1)
+    return -errno;
+
+  rv = ::scan(basepath,st.st_dev,blocksize,_blockmap);
 
   ::compress(_blockmap);
 
@@ -0,0 +1,126 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "bufferpool.hpp"
+#include "math.hpp"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+
+BufferPool::BufferPool()
+  : _mem(NULL),
+    _buflen(0),
+    _count(0),
+    _mutex(PTHREAD_MUTEX_INITIALIZER)
+{
+
+}
+
+BufferPool::~BufferPool()
+{
+  clear();
+}
+
+int
+BufferPool::init(const size_t buflen_,
+                 const size_t count_)
+{
+  int rv;
+  void *mem;
+  size_t total;
+  size_t align;
+  size_t stride;
+
+  clear();
+
+  align  = ::sysconf(_SC_PAGESIZE);
+  stride = math::round_up(buflen_,align);
+  total  = (stride * count_);
+  if(total >= HUGEPAGE_SIZE)
+    {
+      align = HUGEPAGE_SIZE;
+      total = math::round_up(total,align);
+    }
+
+  rv = ::posix_memalign(&mem,align,total);
+  if(rv != 0)
+    return -rv;
+
+#ifdef MADV_HUGEPAGE
+  if(align == HUGEPAGE_SIZE)
+    ::madvise(mem,total,MADV_HUGEPAGE);
+#endif
+
+  ::memset(mem,0,total);
+
+  _mem    = (char*)mem;
+  _buflen = buflen_;
+  _count  = count_;
+  for(size_t i = count_; i != 0; i--)
+    _free.push_back(_mem + ((i - 1) * stride));
+
+  return 0;
+}
+
+void
+BufferPool::clear(void)
+{
+  ::free(_mem);
+
+  _mem    = NULL;
+  _buflen = 0;
+  _count  = 0;
+  _free.clear();
+}
+
+char*
+BufferPool::get(void)
+{
+  char *buf;
+
+  pthread_mutex_lock(&_mutex);
+  if(_free.empty())
+    {
+      buf = NULL;
+    }
+  else
+    {
+      buf = _free.back();
+      _free.pop_back();
+    }
+  pthread_mutex_unlock(&_mutex);
+
+  return buf;
+}
+
+void
+BufferPool::put(char *buf_)
+{
+  if(buf_ == NULL)
+    return;
+
+  pthread_mutex_lock(&_mutex);
+  _free.push_back(buf_);
+  pthread_mutex_unlock(&_mutex);
+}
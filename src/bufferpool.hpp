@@ -0,0 +1,58 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include <pthread.h>
+#include <stddef.h>
+
+/*
+  A fixed set of equally sized buffers carved out of one aligned
+  allocation. Buffers are page aligned (hugepage aligned and backed
+  when the pool is large enough) which makes them suitable for
+  O_DIRECT and lets SG_IO map them without bounce buffering.
+*/
+
+class BufferPool
+{
+public:
+  BufferPool();
+  ~BufferPool();
+
+public:
+  int  init(const size_t buflen,
+            const size_t count);
+  void clear(void);
+
+public:
+  char *get(void);
+  void  put(char *buf);
+
+public:
+  size_t buflen(void) const { return _buflen; }
+  size_t count(void) const { return _count; }
+
+private:
+  char              *_mem;
+  size_t             _buflen;
+  size_t             _count;
+  std::vector<char*> _free;
+  pthread_mutex_t    _mutex;
+};
@@ -0,0 +1,183 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "checkpoint.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+
+std::string
+Checkpoint::filepath(const std::string &output_filepath_)
+{
+  return (output_filepath_ + ".checkpoint");
+}
+
+int
+Checkpoint::read(const std::string &filepath_,
+                 ScanCheckpoint    &checkpoint_)
+{
+  std::string key;
+  std::ifstream file;
+
+  errno = 0;
+  file.open(filepath_.c_str());
+  if(!file.is_open() || file.bad())
+    return (errno ? -errno : -ENOENT);
+
+  checkpoint_ = ScanCheckpoint();
+  while(file >> key)
+    {
+      if(key == "captcha")
+        file >> checkpoint_.captcha;
+      else if(key == "start_block")
+        file >> checkpoint_.start_block;
+      else if(key == "end_block")
+        file >> checkpoint_.end_block;
+      else if(key == "stepping")
+        file >> checkpoint_.stepping;
+      else if(key == "current_block")
+        file >> checkpoint_.current_block;
+      else if(key == "elapsed")
+        file >> checkpoint_.elapsed;
+      else if(key == "badblock")
+        {
+          uint64_t block;
+
+          file >> block;
+          checkpoint_.badblocks.push_back(block);
+        }
+      else if(key == "done")
+        {
+          uint64_t start;
+          uint64_t end;
+
+          file >> start >> end;
+          if(file.fail() || (start >= end))
+            return -EINVAL;
+          checkpoint_.done.add(start,end);
+        }
+      else
+        return -EINVAL;
+
+      if(file.fail())
+        return -EINVAL;
+    }
+
+  if(checkpoint_.captcha.empty() ||
+     (checkpoint_.stepping == 0) ||
+     (checkpoint_.current_block < checkpoint_.start_block))
+    return -EINVAL;
+
+  return 0;
+}
+
+namespace l
+{
+  static
+  int
+  write_all(const int          fd_,
+            const std::string &data_)
+  {
+    ssize_t rv;
+    size_t offset;
+
+    offset = 0;
+    while(offset < data_.size())
+      {
+        rv = ::write(fd_,&data_[offset],data_.size() - offset);
+        if((rv == -1) && (errno == EINTR))
+          continue;
+        if(rv == -1)
+          return -errno;
+
+        offset += rv;
+      }
+
+    return 0;
+  }
+}
+
+/*
+  Written to a temporary file, synced, and renamed over the old one
+  so a crash at any point leaves either the previous or the new
+  checkpoint intact.
+*/
+int
+Checkpoint::write(const std::string    &filepath_,
+                  const ScanCheckpoint &checkpoint_)
+{
+  int fd;
+  int rv;
+  std::string tmppath;
+  std::stringstream ss;
+
+  ss.precision(3);
+  ss << std::fixed
+     << "captcha "       << checkpoint_.captcha       << '\n'
+     << "start_block "   << checkpoint_.start_block   << '\n'
+     << "end_block "     << checkpoint_.end_block     << '\n'
+     << "stepping "      << checkpoint_.stepping      << '\n'
+     << "current_block " << checkpoint_.current_block << '\n'
+     << "elapsed "       << checkpoint_.elapsed       << '\n';
+  for(size_t i = 0; i < checkpoint_.badblocks.size(); i++)
+    ss << "badblock " << checkpoint_.badblocks[i] << '\n';
+  for(BlockRanges::const_iterator i = checkpoint_.done.begin(); i != checkpoint_.done.end(); ++i)
+    ss << "done " << i->first << ' ' << i->second << '\n';
+
+  tmppath = (filepath_ + ".tmp");
+
+  fd = ::open(tmppath.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+  if(fd == -1)
+    return -errno;
+
+  rv = l::write_all(fd,ss.str());
+  if((rv == 0) && (::fsync(fd) == -1))
+    rv = -errno;
+
+  ::close(fd);
+
+  if((rv == 0) && (::rename(tmppath.c_str(),filepath_.c_str()) == -1))
+    rv = -errno;
+  if(rv < 0)
+    ::unlink(tmppath.c_str());
+
+  return rv;
+}
+
+int
+Checkpoint::remove(const std::string &filepath_)
+{
+  int rv;
+
+  rv = ::unlink(filepath_.c_str());
+  if((rv == -1) && (errno != ENOENT))
+    return -errno;
+
+  return 0;
+}
@@ -0,0 +1,56 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "blockranges.hpp"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+/*
+  Everything needed to continue an interrupted scan. All blocks below
+  `current_block` have been read as have those in `done`, which is
+  what was read above it by queued reads, threads, or skipping ahead.
+*/
+struct ScanCheckpoint
+{
+  std::string           captcha;
+  uint64_t              start_block;
+  uint64_t              end_block;
+  uint64_t              stepping;
+  uint64_t              current_block;
+  double                elapsed;
+  std::vector<uint64_t> badblocks;
+  BlockRanges           done;
+};
+
+namespace Checkpoint
+{
+  std::string filepath(const std::string &output_filepath);
+
+  int read(const std::string &filepath,
+           ScanCheckpoint    &checkpoint);
+
+  int write(const std::string    &filepath,
+            const ScanCheckpoint &checkpoint);
+
+  int remove(const std::string &filepath);
+}
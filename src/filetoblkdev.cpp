@@ -16,9 +16,14 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include <fstream>
+#include <sstream>
 #include <string>
 
 #include <dirent.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/sysmacros.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -90,4 +95,55 @@ namespace FileToBlkDev
 
     return FileToBlkDev::find(device);
   }
+
+  static
+  std::string
+  sysfs_path(const dev_t        device_,
+             const std::string &attr_)
+  {
+    std::ostringstream os;
+
+    os << "/sys/dev/block/"
+       << major(device_)
+       << ':'
+       << minor(device_)
+       << '/'
+       << attr_;
+
+    return os.str();
+  }
+
+  /*
+    Byte offset of the filesystem containing `filepath_` within the
+    block device `device_`. Either the filesystem is on the device
+    itself or on one of its partitions in which case sysfs gives the
+    partition's start in 512 byte sectors.
+  */
+  int64_t
+  offset(const std::string &filepath_,
+         const dev_t        device_)
+  {
+    dev_t part;
+    uint64_t start;
+    std::string parent;
+    std::ostringstream devstr;
+
+    part = FileToBlkDev::st_dev(filepath_);
+    if(part == (dev_t)-1)
+      return -ENOENT;
+    if(part == device_)
+      return 0;
+
+    std::ifstream startfile(FileToBlkDev::sysfs_path(part,"start").c_str());
+    std::ifstream parentfile(FileToBlkDev::sysfs_path(part,"../dev").c_str());
+
+    if(!(startfile >> start) || !(parentfile >> parent))
+      return -EXDEV;
+
+    devstr << major(device_) << ':' << minor(device_);
+    if(parent != devstr.str())
+      return -EXDEV;
+
+    return (start * 512);
+  }
 }
@@ -21,10 +21,17 @@
 
 #include <string>
 
+#include <stdint.h>
+#include <sys/types.h>
+
 namespace FileToBlkDev
 {
   std::string
   find(const std::string &filepath);
+
+  int64_t
+  offset(const std::string &filepath,
+         const dev_t        device);
 }
 
 #endif
@@ -0,0 +1,110 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <stdint.h>
+#include <string.h>
+
+
+Histogram::Histogram()
+  : _count(0),
+    _max(0)
+{
+  ::memset(_buckets,0,sizeof(_buckets));
+}
+
+size_t
+Histogram::bucket(const uint64_t value_)
+{
+  int exp;
+  uint64_t sub;
+
+  if(value_ < SUB_BUCKETS)
+    return value_;
+
+  exp = (63 - __builtin_clzll(value_));
+  sub = ((value_ >> (exp - SUB_BITS)) & (SUB_BUCKETS - 1));
+
+  return (((exp - SUB_BITS + 1) * SUB_BUCKETS) + sub);
+}
+
+uint64_t
+Histogram::bucket_max(const size_t idx_)
+{
+  int exp;
+  uint64_t sub;
+  uint64_t lower;
+
+  if(idx_ < SUB_BUCKETS)
+    return idx_;
+
+  exp   = ((idx_ / SUB_BUCKETS) + SUB_BITS - 1);
+  sub   = (idx_ % SUB_BUCKETS);
+  lower = ((SUB_BUCKETS + sub) << (exp - SUB_BITS));
+
+  return (lower + (1ULL << (exp - SUB_BITS)) - 1);
+}
+
+void
+Histogram::add(const uint64_t value_)
+{
+  _buckets[bucket(value_)]++;
+  _count++;
+  _max = std::max(_max,value_);
+}
+
+void
+Histogram::merge(const Histogram &other_)
+{
+  for(size_t i = 0; i < BUCKETS; i++)
+    _buckets[i] += other_._buckets[i];
+  _count += other_._count;
+  _max    = std::max(_max,other_._max);
+}
+
+/*
+  Returns the upper bound of the bucket containing the p'th
+  percentile (0.0 - 100.0) clamped to the max value seen.
+*/
+uint64_t
+Histogram::percentile(const double p_) const
+{
+  uint64_t seen;
+  uint64_t target;
+
+  if(_count == 0)
+    return 0;
+
+  target = (uint64_t)std::ceil((p_ / 100.0) * _count);
+  if(target < 1)
+    target = 1;
+
+  seen = 0;
+  for(size_t i = 0; i < BUCKETS; i++)
+    {
+      seen += _buckets[i];
+      if(seen >= target)
+        return std::min(bucket_max(i),_max);
+    }
+
+  return _max;
+}
@@ -0,0 +1,60 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Log bucketed (HDR style) histogram of latencies in microseconds.
+  Each power of two is split into 16 linear sub-buckets giving ~6%
+  precision over the whole 64bit range in a fixed amount of memory.
+*/
+
+class Histogram
+{
+public:
+  enum
+    {
+      SUB_BITS    = 4,
+      SUB_BUCKETS = (1 << SUB_BITS),
+      BUCKETS     = ((64 - SUB_BITS + 1) * SUB_BUCKETS)
+    };
+
+public:
+  Histogram();
+
+public:
+  void add(const uint64_t value);
+  void merge(const Histogram &other);
+
+public:
+  uint64_t count(void) const { return _count; }
+  uint64_t max(void) const { return _max; }
+  uint64_t percentile(const double p) const;
+
+private:
+  static size_t   bucket(const uint64_t value);
+  static uint64_t bucket_max(const size_t idx);
+
+private:
+  uint64_t _buckets[BUCKETS];
+  uint64_t _count;
+  uint64_t _max;
+};
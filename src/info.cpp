@@ -19,6 +19,7 @@
 #include "info.hpp"
 #include "time.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <vector>
@@ -27,10 +28,28 @@
 
 using namespace std;
 
+namespace l
+{
+  static
+  void
+  print_hms(std::ostream &os_,
+            const size_t  secs_)
+  {
+    os_ << std::setfill('0') << std::setw(2)
+        << (secs_/(60*60)) << ':'
+        << std::setfill('0') << std::setw(2)
+        << ((secs_/60)%60)  << ':'
+        << std::setfill('0') << std::setw(2)
+        << (secs_%60)
+        << std::setfill(' ');
+  }
+}
+
 InfoPrinter::InfoPrinter()
   : _start_time(0),
     _start_block(0),
     _end_block(0),
+    _total_blocks(0),
     _badblocks(NULL)
 {
 
@@ -43,19 +62,44 @@ InfoPrinter::init(const size_t  start_block_,
 {
   std::cout << "\r\x1B[2K" << '\x1B' << '7';
 
-  _start_block = start_block_;
-  _end_block   = end_block_;
-  _badblocks   = badblocks_;
-  _start_time  = Time::get_monotonic();
+  _start_block  = start_block_;
+  _end_block    = end_block_;
+  _total_blocks = (end_block_ - start_block_);
+  _badblocks    = badblocks_;
+  _start_time   = Time::get_monotonic();
+}
+
+/*
+  When only part of [start,end) is going to be read the percentage
+  and eta are based on this rather than the whole range.
+*/
+void
+InfoPrinter::set_total(const size_t total_blocks_)
+{
+  _total_blocks = total_blocks_;
 }
 
 void
 InfoPrinter::print(const size_t current_block_)
+{
+  const size_t badcount = _badblocks->size();
+
+  print(current_block_,
+        (current_block_ - _start_block),
+        badcount,
+        (badcount ? (*_badblocks)[badcount-1] : 0));
+}
+
+void
+InfoPrinter::print(const size_t   current_block_,
+                   const size_t   processed_blocks_,
+                   const size_t   badcount_,
+                   const uint64_t lastbad_)
 {
   const double current_time      = Time::get_monotonic();
-  const size_t badcount          = _badblocks->size();
-  const size_t processed_blocks  = (current_block_ - _start_block);
-  const size_t total_blocks      = (_end_block - _start_block);
+  const size_t badcount          = badcount_;
+  const size_t processed_blocks  = processed_blocks_;
+  const size_t total_blocks      = _total_blocks;
   const size_t blocks_left       = (total_blocks - processed_blocks);
   const double percentage        = (((double)processed_blocks / total_blocks) * 100.0);
   const double time_passed       = (current_time - _start_time);
@@ -69,15 +113,112 @@ InfoPrinter::print(const size_t current_block_)
             << std::setprecision(2)
             << percentage
             << "%); bps: " << blocks_per_second
-            << "; eta: "
-            << std::setfill('0') << std::setw(2)
-            << (time_left/(60*60)) << ':'
-            << std::setfill('0') << std::setw(2)
-            << ((time_left/60)%60)  << ':'
-            << std::setfill('0') << std::setw(2)
-            << (time_left%60)
-            << "; bad: " << badcount;
+            << "; eta: ";
+  l::print_hms(std::cout,time_left);
+  std::cout << "; bad: " << badcount;
   if(badcount)
-    std::cout << "; last: " << (*_badblocks)[badcount-1];
+    std::cout << "; last: " << lastbad_;
   std::cout << std::endl << "\x1B[2K" << std::flush;
 }
+
+InfoTable::InfoTable()
+  : _lines(0)
+{
+
+}
+
+/*
+  Cursor up rather than save / restore cursor as the saved position
+  is lost once the table scrolls the terminal.
+*/
+void
+InfoTable::init(void)
+{
+  _lines = 0;
+  std::cout << "\r\x1B[2K" << std::flush;
+}
+
+void
+InfoTable::print(const std::vector<InfoTableRow> &rows_)
+{
+  size_t width;
+  size_t eta;
+  size_t total_bad;
+  double total_bps;
+  const double current_time = Time::get_monotonic();
+
+  width = 6;
+  for(size_t i = 0; i < rows_.size(); i++)
+    width = std::max(width,rows_[i].name.size());
+
+  std::cout << '\r';
+  if(_lines)
+    std::cout << "\x1B[" << _lines << 'A';
+  std::cout << "\x1B[2K"
+            << std::left << std::setw(width) << "device"
+            << std::right
+            << std::setw(16) << "current"
+            << std::setw(9)  << "%"
+            << std::setw(12) << "bps"
+            << std::setw(10) << "eta"
+            << std::setw(10) << "bad"
+            << std::endl;
+
+  eta       = 0;
+  total_bad = 0;
+  total_bps = 0;
+  for(size_t i = 0; i < rows_.size(); i++)
+    {
+      const InfoTableRow &row = rows_[i];
+      const size_t total_blocks      = (row.end_block - row.start_block);
+      const size_t blocks_left       = (total_blocks - std::min(total_blocks,row.processed_blocks));
+      const double percentage        = (total_blocks ?
+                                        (((double)row.processed_blocks / total_blocks) * 100.0) :
+                                        0.0);
+      const double time_passed       = (current_time - row.start_time);
+      const double blocks_per_second = ((time_passed > 0) ?
+                                        ((double)row.processed_blocks / time_passed) :
+                                        0.0);
+      const size_t time_left         = ((blocks_per_second > 0) ?
+                                        ((double)blocks_left / blocks_per_second) :
+                                        0);
+
+      std::cout << "\x1B[2K"
+                << std::left << std::setw(width) << row.name
+                << std::right
+                << std::setw(16) << row.current_block
+                << std::fixed
+                << std::setprecision(2)
+                << std::setw(9)  << percentage
+                << std::setw(12) << blocks_per_second
+                << "  ";
+      if(row.failed)
+        std::cout << std::setw(8) << "failed";
+      else if(row.done)
+        std::cout << std::setw(8) << "done";
+      else
+        l::print_hms(std::cout,time_left);
+      std::cout << std::setw(10) << row.badcount
+                << std::endl;
+
+      if(!row.done)
+        eta = std::max(eta,time_left);
+      total_bps += blocks_per_second;
+      total_bad += row.badcount;
+    }
+
+  std::cout << "\x1B[2K"
+            << std::left << std::setw(width) << "total"
+            << std::right
+            << std::setw(16) << ""
+            << std::setw(9)  << ""
+            << std::setw(12) << total_bps
+            << "  ";
+  l::print_hms(std::cout,eta);
+  std::cout << std::setw(10) << total_bad
+            << std::endl
+            << "\x1B[2K"
+            << std::flush;
+
+  _lines = (rows_.size() + 2);
+}
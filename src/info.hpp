@@ -22,6 +22,8 @@
 #include "vectors.hpp"
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <stdint.h>
 
@@ -34,16 +36,53 @@ public:
   void init(const size_t  start_block_,
             const size_t  end_block_,
             U64Vec       *badblocks_);
+  void set_total(const size_t total_blocks_);
 
   void print(const size_t current_block_);
+  void print(const size_t   current_block_,
+             const size_t   processed_blocks_,
+             const size_t   badcount_,
+             const uint64_t lastbad_);
 
 private:
   double  _start_time;
   size_t  _start_block;
   size_t  _end_block;
+  size_t  _total_blocks;
   U64Vec *_badblocks;
 };
 
+struct InfoTableRow
+{
+  std::string name;
+  double      start_time;
+  size_t      start_block;
+  size_t      end_block;
+  size_t      current_block;
+  size_t      processed_blocks;
+  size_t      badcount;
+  bool        done;
+  bool        failed;
+};
+
+/*
+  Multi-line equivalent of InfoPrinter: one row per device plus a
+  totals row, redrawn in place by moving back up over the lines last
+  printed.
+*/
+class InfoTable
+{
+public:
+  InfoTable();
+
+public:
+  void init(void);
+  void print(const std::vector<InfoTableRow> &rows_);
+
+private:
+  size_t _lines;
+};
+
 namespace Info
 {
   void
@@ -18,6 +18,7 @@
 
 #include <errno.h>
 #include <inttypes.h>
+#include <linux/blkzoned.h>
 #include <linux/fiemap.h>
 #include <linux/fs.h>
 #include <stdlib.h>
@@ -53,6 +54,22 @@ namespace IOCtl
     return size;
   }
 
+  /*
+    Max size of a single request in 512 byte sectors.
+  */
+  int
+  max_sectors(const int fd)
+  {
+    int rv;
+    unsigned short sectors;
+
+    rv = ::ioctl(fd,BLKSECTGET,&sectors);
+    if(rv == -1)
+      return -errno;
+
+    return sectors;
+  }
+
   int64_t
   size_in_bytes(const int fd)
   {
@@ -122,4 +139,56 @@ namespace IOCtl
 
     return ((rv == -1) ? -errno : rv);
   }
+
+  /*
+    Zone size in 512 byte sectors. 0 if the device is not zoned or the
+    kernel does not support zoned block devices.
+  */
+  int64_t
+  zone_sectors(const int fd)
+  {
+#ifdef BLKGETZONESZ
+    int rv;
+    uint32_t sectors;
+
+    rv = ::ioctl(fd,BLKGETZONESZ,&sectors);
+    if(rv == -1)
+      return ((errno == ENOTTY) ? 0 : -errno);
+
+    return sectors;
+#else
+    return 0;
+#endif
+  }
+
+  /*
+    `report->sector` and `report->nr_zones` must be set by the caller
+    and the report followed by room for that many zones.
+  */
+  int
+  report_zones(const int               fd,
+               struct blk_zone_report *report)
+  {
+    int rv;
+
+    rv = ::ioctl(fd,BLKREPORTZONE,report);
+
+    return ((rv == -1) ? -errno : rv);
+  }
+
+  int
+  reset_zones(const int      fd,
+              const uint64_t sector,
+              const uint64_t sectors)
+  {
+    int rv;
+    struct blk_zone_range range;
+
+    range.sector     = sector;
+    range.nr_sectors = sectors;
+
+    rv = ::ioctl(fd,BLKRESETZONE,&range);
+
+    return ((rv == -1) ? -errno : rv);
+  }
 }
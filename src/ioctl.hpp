@@ -20,12 +20,14 @@
 #define __IOCTL_HPP__
 
 #include <stdint.h>
+#include <linux/blkzoned.h>
 #include <linux/fiemap.h>
 
 namespace IOCtl
 {
   int      logical_block_size(const int fd);
   int      physical_block_size(const int fd);
+  int      max_sectors(const int fd);
 
   int64_t size_in_bytes(const int fd);
   int64_t logical_block_count(const int fd);
@@ -35,6 +37,10 @@ namespace IOCtl
   struct fiemap *extent_map(const int fd);
 
   int block_flush(const int fd);
+
+  int64_t zone_sectors(const int fd);
+  int     report_zones(const int fd, struct blk_zone_report *report);
+  int     reset_zones(const int fd, const uint64_t sector, const uint64_t sectors);
 }
 
 #endif
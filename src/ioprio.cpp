@@ -0,0 +1,81 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "ioprio.hpp"
+
+#include <string>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* linux/ioprio.h is not shipped by all libcs */
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_BE    2
+#define IOPRIO_CLASS_IDLE  3
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_BE_NR       8
+
+#define IOPRIO_PRIO_VALUE(class,data) (((class) << IOPRIO_CLASS_SHIFT) | (data))
+
+
+namespace IOPrio
+{
+  /*
+    'idle' or 'be:N' where N is 0 (highest) to 7 (lowest).
+  */
+  int
+  parse(const std::string &str_,
+        int               *ioprio_)
+  {
+    long level;
+    char *endptr;
+
+    if(str_ == "idle")
+      {
+        *ioprio_ = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE,0);
+        return 0;
+      }
+
+    if(str_.compare(0,3,"be:") || (str_.size() == 3))
+      return -EINVAL;
+
+    level = ::strtol(str_.c_str() + 3,&endptr,10);
+    if((*endptr != '\0') || (level < 0) || (level >= IOPRIO_BE_NR))
+      return -EINVAL;
+
+    *ioprio_ = IOPRIO_PRIO_VALUE(IOPRIO_CLASS_BE,level);
+
+    return 0;
+  }
+
+  /*
+    Applies to the calling process. Threads created afterwards inherit
+    it as do io_uring requests which don't set their own.
+  */
+  int
+  set(const int ioprio_)
+  {
+    int rv;
+
+    rv = ::syscall(__NR_ioprio_set,IOPRIO_WHO_PROCESS,0,ioprio_);
+
+    return ((rv == -1) ? -errno : rv);
+  }
+}
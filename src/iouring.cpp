@@ -0,0 +1,370 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "iouring.hpp"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace l
+{
+  static
+  int
+  io_uring_setup(const unsigned          entries_,
+                 struct io_uring_params *p_)
+  {
+#ifdef __NR_io_uring_setup
+    int rv;
+
+    rv = ::syscall(__NR_io_uring_setup,entries_,p_);
+
+    return ((rv == -1) ? -errno : rv);
+#else
+    return -ENOSYS;
+#endif
+  }
+
+  static
+  int
+  io_uring_enter(const int      fd_,
+                 const unsigned to_submit_,
+                 const unsigned min_complete_,
+                 const unsigned flags_)
+  {
+#ifdef __NR_io_uring_enter
+    int rv;
+
+    rv = ::syscall(__NR_io_uring_enter,fd_,to_submit_,min_complete_,flags_,NULL,0);
+
+    return ((rv == -1) ? -errno : rv);
+#else
+    return -ENOSYS;
+#endif
+  }
+
+  static
+  int
+  io_uring_register(const int       fd_,
+                    const unsigned  opcode_,
+                    void           *arg_,
+                    const unsigned  nr_args_)
+  {
+#ifdef __NR_io_uring_register
+    int rv;
+
+    rv = ::syscall(__NR_io_uring_register,fd_,opcode_,arg_,nr_args_);
+
+    return ((rv == -1) ? -errno : rv);
+#else
+    return -ENOSYS;
+#endif
+  }
+
+  /*
+    IORING_OP_READ and IORING_OP_WRITE arrived in 5.6 alongside the
+    probe. Older kernels set up the ring fine but fail every request
+    with EINVAL so any failure to probe is taken as unsupported.
+  */
+  static
+  int
+  probe_rw(const int fd_)
+  {
+    int rv;
+    size_t size;
+    struct io_uring_probe *probe;
+    const unsigned nr_ops = 256;
+
+    size  = (sizeof(struct io_uring_probe) +
+             (nr_ops * sizeof(struct io_uring_probe_op)));
+    probe = (struct io_uring_probe*)::calloc(1,size);
+    if(probe == NULL)
+      return -ENOMEM;
+
+    rv = l::io_uring_register(fd_,IORING_REGISTER_PROBE,probe,nr_ops);
+    if(rv >= 0)
+      rv = (((probe->ops_len > IORING_OP_READ) &&
+             (probe->ops_len > IORING_OP_WRITE) &&
+             (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+             (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED)) ?
+            0 : -ENOTSUP);
+    else
+      rv = -ENOTSUP;
+
+    ::free(probe);
+
+    return rv;
+  }
+
+  static
+  unsigned
+  load_acquire(const unsigned *p_)
+  {
+    return __atomic_load_n(p_,__ATOMIC_ACQUIRE);
+  }
+
+  static
+  void
+  store_release(unsigned       *p_,
+                const unsigned  v_)
+  {
+    __atomic_store_n(p_,v_,__ATOMIC_RELEASE);
+  }
+}
+
+IOURing::IOURing()
+  : _fd(-1),
+    _pending(0),
+    _sq_ring(MAP_FAILED),
+    _sq_ring_size(0),
+    _cq_ring(MAP_FAILED),
+    _cq_ring_size(0),
+    _sqes((struct io_uring_sqe*)MAP_FAILED),
+    _sqes_size(0),
+    _cqes(NULL)
+{
+
+}
+
+IOURing::~IOURing()
+{
+  destroy();
+}
+
+int
+IOURing::init(const unsigned entries_)
+{
+  int rv;
+  char *sq;
+  char *cq;
+  struct io_uring_params p;
+
+  if(_fd != -1)
+    return -EBUSY;
+
+  ::memset(&p,0,sizeof(p));
+  rv = l::io_uring_setup(entries_,&p);
+  if(rv < 0)
+    return rv;
+  _fd = rv;
+
+  rv = l::probe_rw(_fd);
+  if(rv < 0)
+    {
+      destroy();
+      return rv;
+    }
+
+  _sq_ring_size = (p.sq_off.array + (p.sq_entries * sizeof(unsigned)));
+  _cq_ring_size = (p.cq_off.cqes + (p.cq_entries * sizeof(struct io_uring_cqe)));
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size,_cq_ring_size);
+
+  _sq_ring = ::mmap(NULL,_sq_ring_size,
+                    PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                    _fd,IORING_OFF_SQ_RING);
+  if(_sq_ring == MAP_FAILED)
+    goto error;
+
+  if(p.features & IORING_FEAT_SINGLE_MMAP)
+    _cq_ring = _sq_ring;
+  else
+    _cq_ring = ::mmap(NULL,_cq_ring_size,
+                      PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                      _fd,IORING_OFF_CQ_RING);
+  if(_cq_ring == MAP_FAILED)
+    goto error;
+
+  _sqes_size = (p.sq_entries * sizeof(struct io_uring_sqe));
+  _sqes = (struct io_uring_sqe*)::mmap(NULL,_sqes_size,
+                                       PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,
+                                       _fd,IORING_OFF_SQES);
+  if(_sqes == MAP_FAILED)
+    goto error;
+
+  sq = (char*)_sq_ring;
+  cq = (char*)_cq_ring;
+
+  _sq_head    = (unsigned*)(sq + p.sq_off.head);
+  _sq_tail    = (unsigned*)(sq + p.sq_off.tail);
+  _sq_mask    = (unsigned*)(sq + p.sq_off.ring_mask);
+  _sq_entries = (unsigned*)(sq + p.sq_off.ring_entries);
+  _sq_array   = (unsigned*)(sq + p.sq_off.array);
+  _cq_head    = (unsigned*)(cq + p.cq_off.head);
+  _cq_tail    = (unsigned*)(cq + p.cq_off.tail);
+  _cq_mask    = (unsigned*)(cq + p.cq_off.ring_mask);
+  _cqes       = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+  return 0;
+
+ error:
+  rv = -errno;
+  destroy();
+
+  return rv;
+}
+
+void
+IOURing::destroy(void)
+{
+  if(_sqes != MAP_FAILED)
+    ::munmap(_sqes,_sqes_size);
+  if((_cq_ring != MAP_FAILED) && (_cq_ring != _sq_ring))
+    ::munmap(_cq_ring,_cq_ring_size);
+  if(_sq_ring != MAP_FAILED)
+    ::munmap(_sq_ring,_sq_ring_size);
+  if(_fd != -1)
+    ::close(_fd);
+
+  _fd      = -1;
+  _pending = 0;
+  _sq_ring = MAP_FAILED;
+  _cq_ring = MAP_FAILED;
+  _sqes    = (struct io_uring_sqe*)MAP_FAILED;
+  _cqes    = NULL;
+}
+
+struct io_uring_sqe*
+IOURing::_get_sqe(void)
+{
+  unsigned head;
+  unsigned tail;
+  struct io_uring_sqe *sqe;
+
+  head = l::load_acquire(_sq_head);
+  tail = *_sq_tail;
+  if((tail - head) >= *_sq_entries)
+    return NULL;
+
+  sqe = &_sqes[tail & *_sq_mask];
+  ::memset(sqe,0,sizeof(struct io_uring_sqe));
+
+  _sq_array[tail & *_sq_mask] = (tail & *_sq_mask);
+  l::store_release(_sq_tail,tail + 1);
+  _pending++;
+
+  return sqe;
+}
+
+int
+IOURing::prep_read(const int       fd_,
+                   void           *buf_,
+                   const uint32_t  len_,
+                   const uint64_t  offset_,
+                   const uint64_t  user_data_)
+{
+  struct io_uring_sqe *sqe;
+
+  if(_fd == -1)
+    return -EBADF;
+
+  sqe = _get_sqe();
+  if(sqe == NULL)
+    return -EBUSY;
+
+  sqe->opcode    = IORING_OP_READ;
+  sqe->fd        = fd_;
+  sqe->addr      = (uint64_t)buf_;
+  sqe->len       = len_;
+  sqe->off       = offset_;
+  sqe->user_data = user_data_;
+
+  return 0;
+}
+
+int
+IOURing::prep_write(const int       fd_,
+                    const void     *buf_,
+                    const uint32_t  len_,
+                    const uint64_t  offset_,
+                    const int       rw_flags_,
+                    const uint64_t  user_data_)
+{
+  struct io_uring_sqe *sqe;
+
+  if(_fd == -1)
+    return -EBADF;
+
+  sqe = _get_sqe();
+  if(sqe == NULL)
+    return -EBUSY;
+
+  sqe->opcode    = IORING_OP_WRITE;
+  sqe->fd        = fd_;
+  sqe->addr      = (uint64_t)buf_;
+  sqe->len       = len_;
+  sqe->off       = offset_;
+  sqe->rw_flags  = rw_flags_;
+  sqe->user_data = user_data_;
+
+  return 0;
+}
+
+int
+IOURing::submit(void)
+{
+  int rv;
+
+  if(_pending == 0)
+    return 0;
+
+  rv = l::io_uring_enter(_fd,_pending,0,0);
+  if(rv < 0)
+    return rv;
+
+  _pending -= rv;
+
+  return rv;
+}
+
+/*
+  Returns -EINTR if interrupted by a signal before a completion was
+  available so the caller can service the signal and wait again.
+*/
+int
+IOURing::wait(uint64_t *user_data_,
+              int32_t  *res_)
+{
+  int rv;
+  unsigned head;
+  struct io_uring_cqe *cqe;
+
+  head = *_cq_head;
+  while(head == l::load_acquire(_cq_tail))
+    {
+      rv = l::io_uring_enter(_fd,_pending,1,IORING_ENTER_GETEVENTS);
+      if(rv < 0)
+        return rv;
+      _pending -= rv;
+    }
+
+  cqe = &_cqes[head & *_cq_mask];
+  *user_data_ = cqe->user_data;
+  *res_       = cqe->res;
+
+  l::store_release(_cq_head,head + 1);
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/*
+  Minimal io_uring wrapper built directly on the syscalls so as to not
+  require liburing. Only what is needed to keep a number of reads and
+  writes in flight against a single fd.
+*/
+
+class IOURing
+{
+public:
+  IOURing();
+  ~IOURing();
+
+public:
+  int  init(const unsigned entries);
+  void destroy(void);
+  bool initialized(void) const { return (_fd != -1); }
+
+public:
+  int prep_read(const int       fd,
+                void           *buf,
+                const uint32_t  len,
+                const uint64_t  offset,
+                const uint64_t  user_data);
+  int prep_write(const int       fd,
+                 const void     *buf,
+                 const uint32_t  len,
+                 const uint64_t  offset,
+                 const int       rw_flags,
+                 const uint64_t  user_data);
+
+  int submit(void);
+  int wait(uint64_t *user_data,
+           int32_t  *res);
+
+private:
+  struct io_uring_sqe *_get_sqe(void);
+
+private:
+  int       _fd;
+  unsigned  _pending;
+
+  void     *_sq_ring;
+  size_t    _sq_ring_size;
+  void     *_cq_ring;
+  size_t    _cq_ring_size;
+
+  struct io_uring_sqe *_sqes;
+  size_t               _sqes_size;
+  struct io_uring_cqe *_cqes;
+
+  unsigned *_sq_head;
+  unsigned *_sq_tail;
+  unsigned *_sq_mask;
+  unsigned *_sq_entries;
+  unsigned *_sq_array;
+  unsigned *_cq_head;
+  unsigned *_cq_tail;
+  unsigned *_cq_mask;
+};
@@ -17,7 +17,10 @@
 */
 
 #include "errors.hpp"
+#include "ioprio.hpp"
 #include "options.hpp"
+#include "pattern.hpp"
+#include "simdev.hpp"
 
 #include <string>
 #include <iostream>
@@ -37,7 +40,7 @@ void
 usage(std::ostream &os)
 {
   os <<
-    "usage: bbf [options] <instruction> <path>\n"
+    "usage: bbf [options] <instruction> <path> [<path>...]\n"
     "\n"
     "  instruction\n"
     "    * info                : print out details of the device\n"
@@ -51,7 +54,11 @@ usage(std::ostream &os)
     "    * burnin              : attempts a non-destructive write, read, & verify\n"
     "                            - read block, write block of 0x00, 0x55, 0xAA, 0xFF\n"
     "                            - write back original block if was successfully read\n"
-    "                            - only if the last write,read,verify fails is it bad\n"
+    "                            - a block is bad if any write,read,verify of it\n"
+    "                              fails or the original can't be written back\n"
+    "                            - sequential zones of zoned devices are reset and\n"
+    "                              written whole, losing their data. start and\n"
+    "                              end block can not fall within one\n"
     "    * fsthrash            : hammer the filesystem with calls to core filesystem\n"
     "                            functions to stress the device\n"
     "    * filethrash          : creates a single file that fills the filesystem\n"
@@ -72,15 +79,29 @@ usage(std::ostream &os)
     "                            enhanced overwrites all data (including relocated)\n"
     "                            with vendor specific patterns.\n"
     "  path                    : block device|directory|file to act on\n"
+    "                            'scan' accepts multiple devices which are\n"
+    "                            scanned concurrently\n"
     "\n"
     "  -f, --force             : normally destructive behavior fail if the device\n"
     "                            is mounted. This overrides this check.\n"
-    "  -t, --rwtype <os|ata>   : use OS or ATA reads and writes (default: os)\n"
+    "  -t, --rwtype <os|ata|ata-pio|verify|scsi|scsi-verify|sim:<spec>>\n"
+    "                          : use OS, ATA, or SCSI reads and writes\n"
+    "                            (default: os)\n"
+    "                            'ata' uses DMA, 'ata-pio' PIO transfers\n"
+    "                            'verify' and 'scsi-verify' use READ VERIFY /\n"
+    "                            VERIFY(16) which check the media without\n"
+    "                            transferring data (scan only)\n"
+    "                            'sim:<spec>' replaces the device with a\n"
+    "                            simulated one, i.e. 'sim:size=1G,bad=100-107'.\n"
+    "                            see README for the spec\n"
     "  -q, --quiet             : redirects stdout to /dev/null\n"
     "  -s, --start-block <lba> : block to start from (default: 0)\n"
     "  -e, --end-block <lba>   : block to stop at (default: last block)\n"
     "  -S, --stepping <n>      : number of logical blocks to read at a time\n"
     "                            (default: physical / logical)\n"
+    "  -A, --adaptive          : when scanning grow reads from stepping up to the\n"
+    "                            device's max transfer size while they succeed\n"
+    "                            and halve them on errors\n"
     "  -o, --output <file>     : file to write bad block list to\n"
     "                            defaults to ${HOME}/badblocks.<captcha>\n"
     "  -i, --input <file>      : file to read bad block list from\n"
@@ -88,6 +109,68 @@ usage(std::ostream &os)
     "  -r, --retries <count>   : number of retries on certain reads & writes\n"
     "  -c, --captcha <captcha> : needed when performing destructive operations\n"
     "  -M, --max-errors <n>    : max r/w errors before exiting (default: 1024)\n"
+    "  -D, --direct            : use O_DIRECT to bypass the page cache when\n"
+    "                            scanning, burning in, or fixing (rwtype 'os')\n"
+    "  -Q, --queue-depth <n>   : number of requests to keep in flight when\n"
+    "                            scanning or streaming burnin using io_uring.\n"
+    "                            requires rwtype 'os' (default: 1)\n"
+    "  -T, --threads <n>       : number of threads to scan or burnin with. each\n"
+    "                            works on interleaved stripes of the range\n"
+    "                            (default: 1)\n"
+    "  -L, --slow-threshold <ms>\n"
+    "                          : reads taking at least this long are written to\n"
+    "                            <output>.slow. 0 disables (default: 500)\n"
+    "  -P, --checkpoint-interval <sec>\n"
+    "                          : how often scan writes <output>.checkpoint.\n"
+    "                            0 disables (default: 60)\n"
+    "  -R, --resume            : continue a scan from <output>.checkpoint\n"
+    "  -V, --reverify-known    : scan also re-reads blocks already listed in\n"
+    "                            the input bad block file\n"
+    "  -K, --skip-after <n>    : when scanning skip ahead an exponentially\n"
+    "                            growing distance after n consecutive failed\n"
+    "                            reads. skipped ranges are revisited after the\n"
+    "                            rest of the device. 0 disables (default: 0)\n"
+    "  -a, --allocated-only <mountpoint>\n"
+    "                          : scan only blocks holding file data of the\n"
+    "                            filesystem mounted at mountpoint\n"
+    "  -F, --allocated-first <mountpoint>\n"
+    "                          : scan blocks holding file data first and the\n"
+    "                            rest of the range after\n"
+    "  -N, --sample <n>        : quick scan which reads n randomly placed chunks,\n"
+    "                            one from each of n equal slices of the range,\n"
+    "                            and estimates the failure rate of the whole\n"
+    "                            range. 0 disables (default: 0)\n"
+    "  -I, --ioprio <idle|be:N>: I/O scheduling class & level to run with\n"
+    "                            be:0 is highest and be:7 lowest\n"
+    "  -B, --max-rate <MB/s>   : limit scan, burnin, fix, and fix-file to this\n"
+    "                            many MB (10^6 bytes) per second. 0 disables\n"
+    "                            (default: 0)\n"
+    "  -O, --max-iops <n>      : limit scan, burnin, fix, and fix-file to this\n"
+    "                            many reads and writes per second. 0 disables\n"
+    "                            (default: 0)\n"
+    "  -E, --erc <time>        : while scanning limit the drive's internal error\n"
+    "                            recovery (SCT ERC) to time, i.e. '0.5s' or\n"
+    "                            '700ms'. original values are restored after\n"
+    "                            (ATA drives only)\n"
+    "  -W, --streaming         : destructive burnin which writes each pattern\n"
+    "                            across the whole range and then reads it all\n"
+    "                            back. uses queue depth (default: off)\n"
+    "  -b, --block-size <bytes>: logical block size assumed when scanning a\n"
+    "                            regular file (default: 512)\n"
+    "  -p, --patterns <list>   : comma separated burnin patterns. bytes such\n"
+    "                            as '0x55' or 'random' for data generated\n"
+    "                            from the block address and pass\n"
+    "                            (default: 0x00,0x55,0xAA,0xFF)\n"
+    "  -U, --fua               : burnin writes bypass the drive's write cache\n"
+    "                            (Force Unit Access) so the read back\n"
+    "                            checks the media. implies direct\n"
+    "                            (default: off)\n"
+    "  -Y, --flush-interval <MB>: during a streaming burnin flush the\n"
+    "                            drive's write cache after every MB (10^6\n"
+    "                            bytes) written. the cache is always flushed\n"
+    "                            before verifying. chunked burnin reads each\n"
+    "                            chunk back right away and so needs --fua\n"
+    "                            instead. 0 disables (default: 0)\n"
     "\n";
 }
 
@@ -101,6 +184,24 @@ Options::process_arg(const int          argc,
     case 'f':
       force = true;
       break;
+    case 'D':
+      direct = true;
+      break;
+    case 'A':
+      adaptive = true;
+      break;
+    case 'R':
+      resume = true;
+      break;
+    case 'W':
+      streaming = true;
+      break;
+    case 'U':
+      fua = true;
+      break;
+    case 'V':
+      reverify_known = true;
+      break;
     case 'q':
       quiet++;
       break;
@@ -136,6 +237,112 @@ Options::process_arg(const int          argc,
       if((max_errors == ULLONG_MAX) && (errno == ERANGE))
         return AppError::argument_invalid("max errors value is invalid");
       break;
+    case 'Q':
+      errno = 0;
+      queue_depth = ::strtoull(optarg,NULL,BASE10);
+      if((queue_depth == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid queue depth");
+      if((queue_depth > 1024) || (queue_depth < 1))
+        return AppError::argument_invalid("queue depth must be >= 1 && <= 1024");
+      break;
+    case 'T':
+      errno = 0;
+      threads = ::strtoull(optarg,NULL,BASE10);
+      if((threads == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid thread count");
+      if((threads > 256) || (threads < 1))
+        return AppError::argument_invalid("threads must be >= 1 && <= 256");
+      break;
+    case 'L':
+      errno = 0;
+      slow_threshold = ::strtoull(optarg,NULL,BASE10);
+      if((slow_threshold == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid slow threshold");
+      if(slow_threshold > 3600000)
+        return AppError::argument_invalid("slow threshold must be <= 3600000 ms");
+      break;
+    case 'P':
+      errno = 0;
+      checkpoint_interval = ::strtoull(optarg,NULL,BASE10);
+      if((checkpoint_interval == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid checkpoint interval");
+      break;
+    case 'K':
+      errno = 0;
+      skip_after = ::strtoull(optarg,NULL,BASE10);
+      if((skip_after == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid skip after value");
+      break;
+    case 'N':
+      errno = 0;
+      sample = ::strtoull(optarg,NULL,BASE10);
+      if((sample == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid sample count");
+      break;
+    case 'b':
+      block_size = ::strtoull(optarg,NULL,BASE10);
+      if((block_size < 512) ||
+         (block_size > 65536) ||
+         (block_size & (block_size - 1)))
+        return AppError::argument_invalid("block size must be a power of 2 from 512 to 65536");
+      break;
+    case 'p':
+      {
+        std::vector<Pattern> tmp;
+
+        patterns = optarg;
+        if(Pattern::parse(patterns,&tmp) < 0)
+          return AppError::argument_invalid("patterns must be a comma separated list of bytes (0x00-0xFF) or 'random'");
+      }
+      break;
+    case 'I':
+      if(IOPrio::parse(optarg,&ioprio) < 0)
+        return AppError::argument_invalid("valid ioprio values are 'idle' or 'be:0' through 'be:7'");
+      break;
+    case 'B':
+      errno = 0;
+      max_rate = ::strtoull(optarg,NULL,BASE10);
+      if((max_rate == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid max rate");
+      if(max_rate > 1000000)
+        return AppError::argument_invalid("max rate must be <= 1000000 MB/s");
+      break;
+    case 'Y':
+      errno = 0;
+      flush_interval = ::strtoull(optarg,NULL,BASE10);
+      if((flush_interval == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid flush interval");
+      if(flush_interval > 1000000)
+        return AppError::argument_invalid("flush interval must be <= 1000000 MB");
+      break;
+    case 'O':
+      errno = 0;
+      max_iops = ::strtoull(optarg,NULL,BASE10);
+      if((max_iops == ULLONG_MAX) && (errno == ERANGE))
+        return AppError::argument_invalid("invalid max iops");
+      break;
+    case 'E':
+      {
+        double secs;
+        char *endptr;
+
+        errno = 0;
+        secs  = ::strtod(optarg,&endptr);
+        if(!strcmp(endptr,"ms"))
+          secs /= 1000.0;
+        else if(strcmp(endptr,"s") && strcmp(endptr,""))
+          secs = -1;
+
+        erc = ((secs > 0) ? (uint64_t)((secs * 10.0) + 0.5) : 0);
+        if((errno == ERANGE) || (erc == 0) || (erc > 0xFFFF))
+          return AppError::argument_invalid("error recovery time must be between 0.1s and 6553.5s");
+      }
+      break;
+    case 'a':
+    case 'F':
+      allocated       = optarg;
+      allocated_first = (opt == 'F');
+      break;
     case 'o':
       output_file = optarg;
       break;
@@ -150,8 +357,25 @@ Options::process_arg(const int          argc,
         rwtype = OS;
       else if(!strcmp(optarg,"ata"))
         rwtype = ATA;
+      else if(!strcmp(optarg,"ata-pio"))
+        rwtype = ATA_PIO;
+      else if(!strcmp(optarg,"verify"))
+        rwtype = VERIFY;
+      else if(!strcmp(optarg,"scsi"))
+        rwtype = SCSI;
+      else if(!strncmp(optarg,"sim:",4))
+        {
+          SimDev::Spec spec;
+
+          rwtype = SIM;
+          sim    = (optarg + 4);
+          if(SimDev::parse(sim,&spec) < 0)
+            return AppError::argument_invalid("invalid sim spec: " + sim);
+        }
+      else if(!strcmp(optarg,"scsi-verify"))
+        rwtype = SCSI_VERIFY;
       else
-        return AppError::argument_invalid("valid rwtype values are 'os' or 'ata'");
+        return AppError::argument_invalid("valid rwtype values are 'os', 'ata', 'ata-pio', 'verify', 'scsi', 'scsi-verify', or 'sim:<spec>'");
       break;
     case 'h':
       usage(std::cout);
@@ -208,12 +432,18 @@ AppError
 Options::parse(const int argc,
                char * const argv[])
 {
-  static const char short_options[] = "hqft:r:s:S:e:o:i:c:";
+  static const char short_options[] = "hqfDARVWUt:r:s:S:e:o:i:c:Q:T:L:P:K:a:F:N:I:B:O:E:b:p:Y:";
   static const struct option long_options[] =
     {
       {"help",              no_argument, NULL, 'h'},
       {"quiet",             no_argument, NULL, 'q'},
       {"force",             no_argument, NULL, 'f'},
+      {"direct",            no_argument, NULL, 'D'},
+      {"adaptive",          no_argument, NULL, 'A'},
+      {"resume",            no_argument, NULL, 'R'},
+      {"reverify-known",    no_argument, NULL, 'V'},
+      {"streaming",         no_argument, NULL, 'W'},
+      {"fua",               no_argument, NULL, 'U'},
       {"rwtype",      required_argument, NULL, 't'},
       {"retries",     required_argument, NULL, 'r'},
       {"start-block", required_argument, NULL, 's'},
@@ -223,6 +453,21 @@ Options::parse(const int argc,
       {"input",       required_argument, NULL, 'i'},
       {"captcha",     required_argument, NULL, 'c'},
       {"max-errors",  required_argument, NULL, 'M'},
+      {"queue-depth", required_argument, NULL, 'Q'},
+      {"threads",     required_argument, NULL, 'T'},
+      {"slow-threshold", required_argument, NULL, 'L'},
+      {"checkpoint-interval", required_argument, NULL, 'P'},
+      {"skip-after",  required_argument, NULL, 'K'},
+      {"allocated-only",  required_argument, NULL, 'a'},
+      {"allocated-first", required_argument, NULL, 'F'},
+      {"sample",      required_argument, NULL, 'N'},
+      {"ioprio",      required_argument, NULL, 'I'},
+      {"max-rate",    required_argument, NULL, 'B'},
+      {"max-iops",    required_argument, NULL, 'O'},
+      {"erc",         required_argument, NULL, 'E'},
+      {"block-size",  required_argument, NULL, 'b'},
+      {"patterns",    required_argument, NULL, 'p'},
+      {"flush-interval", required_argument, NULL, 'Y'},
       {NULL,                          0, NULL,   0}
     };
 
@@ -254,6 +499,8 @@ Options::parse(const int argc,
 
   instruction = instr_from_string(argv[optind]);
   device      = argv[optind+1];
+  for(int i = (optind + 1); i < argc; i++)
+    devices.push_back(argv[i]);
 
   return validate();
 }
@@ -300,6 +547,60 @@ Options::validate(void) const
 
   if(start_block >= end_block)
     return AppError::argument_invalid("start block >= end block");
+  if(((rwtype == VERIFY) || (rwtype == SCSI_VERIFY)) && (instruction != SCAN))
+    return AppError::argument_invalid("rwtype 'verify' and 'scsi-verify' only supported by 'scan'");
+  if((queue_depth > 1) && (rwtype != OS) && (rwtype != SIM))
+    return AppError::argument_invalid("queue depth > 1 requires rwtype 'os' or 'sim'");
+  if((queue_depth > 1) && (threads > 1))
+    return AppError::argument_invalid("queue depth and threads are mutually exclusive");
+  if(resume && (instruction != SCAN))
+    return AppError::argument_invalid("resume only supported by 'scan'");
+  if(resume && (output_file == "-"))
+    return AppError::argument_invalid("resume requires an output file");
+  if(skip_after && ((queue_depth > 1) || (threads > 1)))
+    return AppError::argument_invalid("skip after can not be used with queue depth or threads");
+  if(adaptive && ((queue_depth > 1) || (threads > 1)))
+    return AppError::argument_invalid("adaptive can not be used with queue depth or threads");
+  if((devices.size() > 1) && (instruction != SCAN))
+    return AppError::argument_invalid("multiple paths only supported by 'scan'");
+  if((devices.size() > 1) && (!output_file.empty() || !input_file.empty()))
+    return AppError::argument_invalid("input and output files can not be used with multiple devices");
+  if((devices.size() > 1) && (threads > 1))
+    return AppError::argument_invalid("threads can not be used with multiple devices");
+  if(!allocated.empty() && (instruction != SCAN))
+    return AppError::argument_invalid("allocated only supported by 'scan'");
+  if(!allocated.empty() && (devices.size() > 1))
+    return AppError::argument_invalid("allocated can not be used with multiple devices");
+  if(allocated_first && resume)
+    return AppError::argument_invalid("allocated first can not be resumed");
+  if((max_rate || max_iops) &&
+     (instruction != SCAN) &&
+     (instruction != BURNIN) &&
+     (instruction != FIX) &&
+     (instruction != FIX_FILE))
+    return AppError::argument_invalid("max rate and max iops only supported by 'scan', 'burnin', 'fix', and 'fix-file'");
+  if(erc && (instruction != SCAN))
+    return AppError::argument_invalid("erc only supported by 'scan'");
+  if(streaming && (instruction != BURNIN))
+    return AppError::argument_invalid("streaming only supported by 'burnin'");
+  if(block_size && (instruction != SCAN))
+    return AppError::argument_invalid("block size only supported by 'scan'");
+  if(!patterns.empty() && (instruction != BURNIN))
+    return AppError::argument_invalid("patterns only supported by 'burnin'");
+  if(fua && (instruction != BURNIN))
+    return AppError::argument_invalid("fua only supported by 'burnin'");
+  if(flush_interval && ((instruction != BURNIN) || !streaming))
+    return AppError::argument_invalid("flush interval only supported by streaming 'burnin'");
+  if(flush_interval && fua)
+    return AppError::argument_invalid("flush interval has no effect with fua");
+  if(streaming && (threads > 1))
+    return AppError::argument_invalid("streaming burnin uses queue depth rather than threads");
+  if(sample && (instruction != SCAN))
+    return AppError::argument_invalid("sample only supported by 'scan'");
+  if(sample && ((queue_depth > 1) || (threads > 1) || adaptive || skip_after))
+    return AppError::argument_invalid("sample can not be used with queue depth, threads, adaptive, or skip after");
+  if(sample && (resume || !allocated.empty() || (devices.size() > 1)))
+    return AppError::argument_invalid("sample can not be used with resume, allocated, or multiple devices");
 
   return AppError::success();
 }
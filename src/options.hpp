@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 struct Options
 {
@@ -53,23 +54,51 @@ public:
   enum RWType
     {
       ATA,
-      OS
+      ATA_PIO,
+      OS,
+      VERIFY,
+      SCSI,
+      SCSI_VERIFY,
+      SIM
     };
 
 public:
   Options() :
+    instruction(_INVALID),
+    rwtype(OS),
+    device(),
+    devices(),
     quiet(0),
     retries(0),
     start_block(0),
     end_block(~0ULL),
     stepping(0),
     max_errors(1024),
+    queue_depth(1),
+    threads(1),
+    slow_threshold(500),
+    checkpoint_interval(60),
+    skip_after(0),
+    sample(0),
+    max_rate(0),
+    max_iops(0),
+    ioprio(0),
+    erc(0),
+    block_size(0),
+    flush_interval(0),
+    sim(),
+    patterns(),
+    allocated(),
     output_file(),
     input_file(),
-    instruction(_INVALID),
-    device(),
-    rwtype(OS),
-    force(false)
+    force(false),
+    direct(false),
+    adaptive(false),
+    resume(false),
+    reverify_known(false),
+    allocated_first(false),
+    streaming(false),
+    fua(false)
   {}
 
 public:
@@ -86,6 +115,7 @@ public:
   Instruction instruction;
   RWType      rwtype;
   std::string device;
+  std::vector<std::string> devices;
 
   int         quiet;
   long        retries;
@@ -93,8 +123,30 @@ public:
   uint64_t    end_block;
   uint64_t    stepping;
   uint64_t    max_errors;
+  uint64_t    queue_depth;
+  uint64_t    threads;
+  uint64_t    slow_threshold;
+  uint64_t    checkpoint_interval;
+  uint64_t    skip_after;
+  uint64_t    sample;
+  uint64_t    max_rate;
+  uint64_t    max_iops;
+  int         ioprio;
+  uint64_t    erc;
+  uint64_t    block_size;
+  uint64_t    flush_interval;
+  std::string sim;
+  std::string patterns;
+  std::string allocated;
   std::string output_file;
   std::string input_file;
   std::string captcha;
   bool        force;
+  bool        direct;
+  bool        adaptive;
+  bool        resume;
+  bool        reverify_known;
+  bool        allocated_first;
+  bool        streaming;
+  bool        fua;
 };
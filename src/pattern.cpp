@@ -0,0 +1,238 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "pattern.hpp"
+#include "verify.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UNIT       512
+#define UNIT_WORDS (UNIT / sizeof(uint32_t))
+
+namespace l
+{
+  static
+  uint64_t
+  mix64(uint64_t x_)
+  {
+    x_ ^= (x_ >> 30);
+    x_ *= 0xBF58476D1CE4E5B9ULL;
+    x_ ^= (x_ >> 27);
+    x_ *= 0x94D049BB133111EBULL;
+    x_ ^= (x_ >> 31);
+
+    return x_;
+  }
+
+  static
+  inline
+  uint32_t
+  mix32(uint32_t x_)
+  {
+    x_ ^= (x_ >> 16);
+    x_ *= 0x85EBCA6BU;
+    x_ ^= (x_ >> 13);
+    x_ *= 0xC2B2AE35U;
+    x_ ^= (x_ >> 16);
+
+    return x_;
+  }
+
+  /*
+    Both halves of the unit's 64bit key go into every word so units
+    only repeat if their keys do, which as mix64 is a bijection means
+    never within a pattern. Each word depends only on the key and its
+    index so the fixed length loops vectorise.
+  */
+  static
+  inline
+  uint32_t
+  random_word(const uint32_t lo_,
+              const uint32_t hi_,
+              const uint32_t i_)
+  {
+    return (l::mix32(lo_ + (i_ * 0x9E3779B9U)) ^
+            l::mix32(hi_ + (i_ * 0x7F4A7C15U)));
+  }
+
+  static
+  void
+  random_unit(const uint64_t  key_,
+              uint32_t       *words_)
+  {
+    const uint32_t lo = (uint32_t)key_;
+    const uint32_t hi = (uint32_t)(key_ >> 32);
+
+    for(uint32_t i = 0; i < UNIT_WORDS; i++)
+      words_[i] = l::random_word(lo,hi,i);
+  }
+
+  static
+  bool
+  random_unit_matches(const uint64_t  key_,
+                      const uint32_t *words_)
+  {
+    uint32_t diff;
+    const uint32_t lo = (uint32_t)key_;
+    const uint32_t hi = (uint32_t)(key_ >> 32);
+
+    diff = 0;
+    for(uint32_t i = 0; i < UNIT_WORDS; i++)
+      diff |= (words_[i] ^ l::random_word(lo,hi,i));
+
+    return (diff == 0);
+  }
+
+  static
+  uint64_t
+  unit_key(const uint64_t key_,
+           const uint64_t offset_)
+  {
+    return l::mix64(key_ ^ (offset_ / UNIT));
+  }
+}
+
+/*
+  Comma separated list of bytes (`0x55`) and `random`.
+*/
+int
+Pattern::parse(const std::string    &str_,
+               std::vector<Pattern> *patterns_)
+{
+  char *end;
+  unsigned long byte;
+  Pattern pattern;
+  std::string item;
+  std::istringstream ss(str_);
+
+  patterns_->clear();
+  while(std::getline(ss,item,','))
+    {
+      pattern.byte = 0;
+      pattern.key  = 0;
+      if(item == "random")
+        {
+          pattern.type = RANDOM;
+          pattern.key  = l::mix64(patterns_->size() + 1);
+        }
+      else
+        {
+          errno = 0;
+          byte  = ::strtoul(item.c_str(),&end,0);
+          if(item.empty() || (*end != '\0') || (errno != 0) || (byte > 0xFF))
+            return -EINVAL;
+
+          pattern.type = BYTE;
+          pattern.byte = byte;
+        }
+
+      patterns_->push_back(pattern);
+    }
+
+  if(patterns_->empty())
+    return -EINVAL;
+
+  return 0;
+}
+
+std::vector<Pattern>
+Pattern::defaults(void)
+{
+  std::vector<Pattern> patterns;
+
+  Pattern::parse("0x00,0x55,0xAA,0xFF",&patterns);
+
+  return patterns;
+}
+
+std::string
+Pattern::name(void) const
+{
+  char buf[8];
+
+  if(type == RANDOM)
+    return "random";
+
+  ::snprintf(buf,sizeof(buf),"0x%02x",byte);
+
+  return buf;
+}
+
+void
+Pattern::fill(const uint64_t  offset_,
+              char           *buf_,
+              const uint64_t  len_) const
+{
+  if(type == BYTE)
+    {
+      ::memset(buf_,byte,len_);
+      return;
+    }
+
+  for(uint64_t o = 0; o < len_; o += UNIT)
+    l::random_unit(l::unit_key(key,offset_ + o),(uint32_t*)&buf_[o]);
+}
+
+bool
+Pattern::matches(const uint64_t  offset_,
+                 const char     *buf_,
+                 const uint64_t  len_) const
+{
+  if(type == BYTE)
+    return verify::equal(byte,buf_,len_);
+
+  for(uint64_t o = 0; o < len_; o += UNIT)
+    if(!l::random_unit_matches(l::unit_key(key,offset_ + o),
+                               (const uint32_t*)&buf_[o]))
+      return false;
+
+  return true;
+}
+
+/*
+  Only called for data which didn't match so the random unit being
+  regenerated into a temporary isn't a concern.
+*/
+uint64_t
+Pattern::flipped_bits(const uint64_t  offset_,
+                      const char     *buf_,
+                      const uint64_t  len_) const
+{
+  uint64_t bits;
+  uint32_t words[UNIT_WORDS];
+
+  if(type == BYTE)
+    return verify::flipped_bits(byte,buf_,len_);
+
+  bits = 0;
+  for(uint64_t o = 0; o < len_; o += UNIT)
+    {
+      l::random_unit(l::unit_key(key,offset_ + o),words);
+      bits += verify::flipped_bits((const char*)words,&buf_[o],UNIT);
+    }
+
+  return bits;
+}
@@ -0,0 +1,66 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+/*
+  A burnin pattern generated on the fly from a byte offset on the
+  device so nothing but the buffer being written or verified needs to
+  be held in memory however many patterns are used. `random` is
+  pseudo-random data keyed by the pass and the 512 byte unit it is
+  written to so misdirected writes and address decoding faults are
+  caught and the data can't be compressed or deduplicated. Offsets
+  and lengths are multiples of 512.
+*/
+
+class Pattern
+{
+public:
+  enum Type
+    {
+      BYTE,
+      RANDOM
+    };
+
+public:
+  static int parse(const std::string    &str,
+                   std::vector<Pattern> *patterns);
+  static std::vector<Pattern> defaults(void);
+
+public:
+  std::string name(void) const;
+  void fill(const uint64_t  offset,
+            char           *buf,
+            const uint64_t  len) const;
+  bool matches(const uint64_t  offset,
+               const char     *buf,
+               const uint64_t  len) const;
+  uint64_t flipped_bits(const uint64_t  offset,
+                        const char     *buf,
+                        const uint64_t  len) const;
+
+public:
+  Type     type;
+  uint8_t  byte;
+  uint64_t key;
+};
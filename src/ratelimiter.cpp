@@ -0,0 +1,105 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "ratelimiter.hpp"
+#include "time.hpp"
+
+#include <algorithm>
+
+#include <pthread.h>
+#include <stdint.h>
+
+
+RateLimiter::RateLimiter()
+  : _mutex(PTHREAD_MUTEX_INITIALIZER),
+    _last(0)
+{
+  set(0,0);
+}
+
+/*
+  Bursts are limited to a tenth of a second worth of tokens so the
+  device sees a steady rate rather than a second of flat out reads
+  followed by silence. 0 disables either limit.
+*/
+void
+RateLimiter::set(const uint64_t bytes_per_sec_,
+                 const uint64_t ops_per_sec_)
+{
+  _bytes.rate     = bytes_per_sec_;
+  _bytes.capacity = (bytes_per_sec_ / 10.0);
+  _bytes.tokens   = _bytes.capacity;
+
+  _ops.rate       = ops_per_sec_;
+  _ops.capacity   = std::max(ops_per_sec_ / 10.0,1.0);
+  _ops.tokens     = _ops.capacity;
+
+  _last = Time::get_monotonic();
+}
+
+bool
+RateLimiter::enabled(void) const
+{
+  return ((_bytes.rate > 0) || (_ops.rate > 0));
+}
+
+/*
+  Refill the bucket for the time passed, take `count_` tokens, and
+  return how long to wait for any shortfall to be paid back.
+*/
+double
+RateLimiter::take(Bucket         &bucket_,
+                  const double    elapsed_,
+                  const uint64_t  count_)
+{
+  if(bucket_.rate <= 0)
+    return 0;
+
+  bucket_.tokens  = std::min(bucket_.tokens + (elapsed_ * bucket_.rate),
+                             bucket_.capacity);
+  bucket_.tokens -= count_;
+
+  return ((bucket_.tokens < 0) ? (-bucket_.tokens / bucket_.rate) : 0);
+}
+
+/*
+  Returns how long the caller was held up for.
+*/
+double
+RateLimiter::acquire(const uint64_t bytes_)
+{
+  double now;
+  double wait;
+
+  if(!enabled())
+    return 0;
+
+  pthread_mutex_lock(&_mutex);
+  now   = Time::get_monotonic();
+  wait  = std::max(RateLimiter::take(_bytes,now - _last,bytes_),
+                   RateLimiter::take(_ops,now - _last,1));
+  _last = now;
+  pthread_mutex_unlock(&_mutex);
+
+  if(wait <= 0)
+    return 0;
+
+  Time::sleep(wait);
+
+  return wait;
+}
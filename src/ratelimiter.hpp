@@ -0,0 +1,60 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+  Token bucket limiting both bytes and operations per second. Shared
+  by everything doing I/O to a device so the limit holds regardless
+  of chunk size, queue depth, or thread count. A request which can't
+  be covered by the tokens on hand goes into debt and the caller
+  sleeps until it is paid off so larger requests still work.
+*/
+
+class RateLimiter
+{
+public:
+  RateLimiter();
+
+public:
+  void set(const uint64_t bytes_per_sec,
+           const uint64_t ops_per_sec);
+  bool enabled(void) const;
+  double acquire(const uint64_t bytes);
+
+private:
+  struct Bucket
+  {
+    double rate;
+    double capacity;
+    double tokens;
+  };
+
+  static double take(Bucket         &bucket,
+                     const double    elapsed,
+                     const uint64_t  count);
+
+private:
+  pthread_mutex_t _mutex;
+  double          _last;
+  Bucket          _bytes;
+  Bucket          _ops;
+};
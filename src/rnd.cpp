@@ -21,6 +21,8 @@
 #include <string>
 #include <vector>
 
+#include <stdint.h>
+
 
 namespace rnd
 {
@@ -30,6 +32,19 @@ namespace rnd
     std::srand(std::time(NULL));
   }
 
+  // rand() only guarantees 15 bits
+  uint64_t
+  u64(void)
+  {
+    uint64_t rv;
+
+    rv = 0;
+    for(int i = 0; i < 5; i++)
+      rv = ((rv << 15) ^ (std::rand() & 0x7FFF));
+
+    return rv;
+  }
+
   std::string
   str(int len_)
   {
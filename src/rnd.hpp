@@ -21,8 +21,12 @@
 #include <string>
 #include <vector>
 
+#include <stdint.h>
+
 namespace rnd
 {
+  void        init(void);
+  uint64_t    u64(void);
   std::string str(int len);
   std::string filename(void);
 
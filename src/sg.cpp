@@ -142,6 +142,7 @@ namespace sg
       case ATA_OP_READ_DMA_EXT:
       case ATA_OP_WRITE_PIO_EXT:
       case ATA_OP_WRITE_DMA_EXT:
+      case ATA_OP_WRITE_DMA_FUA_EXT:
       case ATA_OP_READ_VERIFY_EXT:
       case ATA_OP_WRITE_UNC_EXT:
       case ATA_OP_READ_NATIVE_MAX_EXT:
@@ -177,6 +178,7 @@ namespace sg
       case ATA_OP_READ_DMA_EXT:
       case ATA_OP_READ_FPDMA:
       case ATA_OP_WRITE_DMA_EXT:
+      case ATA_OP_WRITE_DMA_FUA_EXT:
       case ATA_OP_WRITE_FPDMA:
       case ATA_OP_READ_DMA:
       case ATA_OP_WRITE_DMA:
@@ -437,6 +439,8 @@ namespace sg
     ident.supports_sata_gen1 = !!(buf16[76] & 0x0002);
     ident.supports_sata_gen2 = !!(buf16[76] & 0x0004);
     ident.supports_sata_gen3 = !!(buf16[76] & 0x0008);
+    ident.sct_supported      = !!(buf16[206] & 0x0001);
+    ident.sct_erc_supported  = (ident.sct_supported && (buf16[206] & 0x0008));
 
     ident.security_normal_erase_time   = (((buf16[89] & 0x8000) ?
                                            (buf16[89] & 0x7FFF) :
@@ -476,12 +480,16 @@ namespace sg
     return rv;
   }
 
+  /*
+    `dma_` selects READ DMA EXT (SG_DMA) or READ SECTORS EXT (SG_PIO).
+  */
   int
   read_block(const int       fd_,
              const uint64_t  lba_,
              const uint64_t  blocks_,
              void           *buf_,
              const size_t    buflen_,
+             const int       dma_,
              const int       timeout_)
   {
     int blocks;
@@ -491,18 +499,50 @@ namespace sg
     blocks = blocks_;
     if(blocks >= 65536)
       blocks = 0;
-    instruction = ATA_OP_READ_PIO_EXT;
+    instruction = ((dma_ == SG_DMA) ?
+                   ATA_OP_READ_DMA_EXT :
+                   ATA_OP_READ_PIO_EXT);
     tf_init(&tf,instruction,lba_,blocks);
 
-    return exec(fd_,SG_READ,SG_PIO,&tf,buf_,buflen_,timeout_);
+    return exec(fd_,SG_READ,is_dma(instruction),&tf,buf_,buflen_,timeout_);
   }
 
+  /*
+    READ VERIFY SECTORS EXT: the drive reads the sectors from media
+    and reports errors the same as a read but no data is transferred
+    to the host.
+  */
+  int
+  verify_block(const int      fd_,
+               const uint64_t lba_,
+               const uint64_t blocks_,
+               const int      timeout_)
+  {
+    int blocks;
+    struct ata_tf tf;
+
+    blocks = blocks_;
+    if(blocks >= 65536)
+      blocks = 0;
+    tf_init(&tf,ATA_OP_READ_VERIFY_EXT,lba_,blocks);
+
+    return exec(fd_,SG_READ,SG_PIO,&tf,NULL,0,timeout_);
+  }
+
+  /*
+    `dma_` selects WRITE DMA EXT (SG_DMA) or WRITE SECTORS EXT
+    (SG_PIO). With `fua_` WRITE DMA FUA EXT is used which doesn't
+    complete until the data is on the media. There is no PIO
+    equivalent.
+  */
   int
   write_block(const int       fd_,
               const uint64_t  lba_,
               const uint64_t  blocks_,
               const void     *buf_,
               const size_t    buflen_,
+              const int       dma_,
+              const bool      fua_,
               const int       timeout_)
   {
     int blocks;
@@ -512,10 +552,219 @@ namespace sg
     blocks = blocks_;
     if(blocks >= 65536)
       blocks = 0;
-    instruction = ATA_OP_WRITE_PIO_EXT;
+    instruction = ((dma_ == SG_DMA) ?
+                   (fua_ ? ATA_OP_WRITE_DMA_FUA_EXT : ATA_OP_WRITE_DMA_EXT) :
+                   ATA_OP_WRITE_PIO_EXT);
     tf_init(&tf,instruction,lba_,blocks);
 
-    return exec(fd_,SG_WRITE,SG_PIO,&tf,(void*)buf_,buflen_,timeout_);
+    return exec(fd_,SG_WRITE,is_dma(instruction),&tf,(void*)buf_,buflen_,timeout_);
+  }
+
+  /*
+    Issue an SCT command. CK_COND is set so the SAT layer returns the
+    ATA output registers in an ATA Status Return sense descriptor
+    which is where some SCT functions put their result.
+  */
+  static
+  int
+  sct_exec(const int       fd_,
+           const uint16_t  action_,
+           const uint16_t  function_,
+           const uint16_t  selection_,
+           const uint16_t  value_,
+           struct ata_tf  *out_,
+           const int       timeout_)
+  {
+    int rv;
+    struct ata_tf tf;
+    uint8_t data[512]          = {0};
+    uint8_t cdb[SG_ATA_16_LEN] = {0};
+    uint8_t sb[32]             = {0};
+    sg_io_hdr_t io_hdr         = {};
+    const uint8_t *desc        = &sb[8];
+
+    // little endian words
+    data[0] = (action_    & 0xFF);
+    data[1] = (action_    >> 8);
+    data[2] = (function_  & 0xFF);
+    data[3] = (function_  >> 8);
+    data[4] = (selection_ & 0xFF);
+    data[5] = (selection_ >> 8);
+    data[6] = (value_     & 0xFF);
+    data[7] = (value_     >> 8);
+
+    tf_init(&tf,ATA_OP_SMART,0,1);
+    tf.lob.feat = ATA_SMART_WRITE_LOG;
+    tf.lob.lbal = ATA_LOG_SCT_COMMAND;
+    tf.lob.lbam = ATA_SMART_LBAM;
+    tf.lob.lbah = ATA_SMART_LBAH;
+
+    cdb[1]         = calculate_cdb1(SG_PIO,SG_WRITE,data);
+    cdb[2]         = (calculate_cdb2(SG_WRITE,data) | SG_CDB2_CHECK_COND);
+    io_hdr.cmd_len = populate_cdb_from_tf(cdb,&tf);
+    populate_io_hdr(&io_hdr,cdb,sb,&tf,data,sizeof(data),SG_WRITE,timeout_);
+
+    rv = sg::exec_core(fd_,io_hdr);
+    if(rv < 0)
+      return rv;
+    if(out_ == NULL)
+      return 0;
+
+    // descriptor format sense with an ATA Status Return descriptor
+    if((sb[0] != 0x72) || (desc[0] != 0x09))
+      return -EIO;
+
+    memset(out_,0,sizeof(struct ata_tf));
+    out_->error     = desc[3];
+    out_->hob.nsect = desc[4];
+    out_->lob.nsect = desc[5];
+    out_->hob.lbal  = desc[6];
+    out_->lob.lbal  = desc[7];
+    out_->hob.lbam  = desc[8];
+    out_->lob.lbam  = desc[9];
+    out_->hob.lbah  = desc[10];
+    out_->lob.lbah  = desc[11];
+    out_->dev       = desc[12];
+    out_->status    = desc[13];
+
+    if(out_->status & ATA_STAT_ERR)
+      return -EIO;
+
+    return 0;
+  }
+
+  /*
+    `selection_` is SCT_ERC_READ or SCT_ERC_WRITE. 0 means the drive
+    has no limit.
+  */
+  int
+  sct_erc_get(const int  fd_,
+              const int  selection_,
+              uint16_t  *deciseconds_,
+              const int  timeout_)
+  {
+    int rv;
+    struct ata_tf out;
+
+    rv = sct_exec(fd_,
+                  SCT_ACTION_ERC,
+                  SCT_ERC_FUNCTION_GET,
+                  selection_,
+                  0,
+                  &out,
+                  timeout_);
+    if(rv < 0)
+      return rv;
+
+    *deciseconds_ = (out.lob.nsect | (out.lob.lbal << 8));
+
+    return 0;
+  }
+
+  int
+  sct_erc_set(const int      fd_,
+              const int      selection_,
+              const uint16_t deciseconds_,
+              const int      timeout_)
+  {
+    return sct_exec(fd_,
+                    SCT_ACTION_ERC,
+                    SCT_ERC_FUNCTION_SET,
+                    selection_,
+                    deciseconds_,
+                    NULL,
+                    timeout_);
+  }
+
+  /*
+    Native SCSI commands for SAS drives which don't accept ATA
+    PASS-THROUGH. Errors are decoded by exec_core the same way.
+  */
+  static
+  int
+  scsi_exec16(const int       fd_,
+              const uint8_t   op_,
+              const uint64_t  lba_,
+              const uint32_t  blocks_,
+              const uint8_t   cdb1_,
+              const int       rw_,
+              void           *data_,
+              const size_t    data_bytes_,
+              const int       timeout_)
+  {
+    uint8_t cdb[16]    = {0};
+    uint8_t sb[32]     = {0};
+    sg_io_hdr_t io_hdr = {};
+
+    cdb[ 0] = op_;
+    cdb[ 1] = cdb1_;
+    cdb[ 2] = (lba_ >> 56);
+    cdb[ 3] = (lba_ >> 48);
+    cdb[ 4] = (lba_ >> 40);
+    cdb[ 5] = (lba_ >> 32);
+    cdb[ 6] = (lba_ >> 24);
+    cdb[ 7] = (lba_ >> 16);
+    cdb[ 8] = (lba_ >>  8);
+    cdb[ 9] = (lba_ >>  0);
+    cdb[10] = (blocks_ >> 24);
+    cdb[11] = (blocks_ >> 16);
+    cdb[12] = (blocks_ >>  8);
+    cdb[13] = (blocks_ >>  0);
+
+    io_hdr.interface_id    = 'S';
+    io_hdr.dxfer_direction = dxfer_direction(data_,rw_);
+    io_hdr.dxferp          = data_;
+    io_hdr.dxfer_len       = (data_ ? data_bytes_ : 0);
+    io_hdr.cmdp            = cdb;
+    io_hdr.cmd_len         = sizeof(cdb);
+    io_hdr.sbp             = sb;
+    io_hdr.mx_sb_len       = sizeof(sb);
+    io_hdr.pack_id         = lba_;
+    io_hdr.timeout         = (timeout_ ? timeout_ : 1000);
+
+    return sg::exec_core(fd_,io_hdr);
+  }
+
+  int
+  scsi_read_block(const int       fd_,
+                  const uint64_t  lba_,
+                  const uint64_t  blocks_,
+                  void           *buf_,
+                  const size_t    buflen_,
+                  const bool      fua_,
+                  const int       timeout_)
+  {
+    return scsi_exec16(fd_,SCSI_OP_READ_16,lba_,blocks_,
+                       (fua_ ? SCSI_CDB1_FUA : 0),
+                       SG_READ,buf_,buflen_,timeout_);
+  }
+
+  int
+  scsi_write_block(const int       fd_,
+                   const uint64_t  lba_,
+                   const uint64_t  blocks_,
+                   const void     *buf_,
+                   const size_t    buflen_,
+                   const bool      fua_,
+                   const int       timeout_)
+  {
+    return scsi_exec16(fd_,SCSI_OP_WRITE_16,lba_,blocks_,
+                       (fua_ ? SCSI_CDB1_FUA : 0),
+                       SG_WRITE,(void*)buf_,buflen_,timeout_);
+  }
+
+  /*
+    BYTCHK = 0: the device verifies the media itself and no data is
+    transferred.
+  */
+  int
+  scsi_verify_block(const int      fd_,
+                    const uint64_t lba_,
+                    const uint64_t blocks_,
+                    const int      timeout_)
+  {
+    return scsi_exec16(fd_,SCSI_OP_VERIFY_16,lba_,blocks_,0,
+                       SG_READ,NULL,0,timeout_);
   }
 
   int
@@ -163,6 +163,7 @@ namespace sg
       ATA_OP_WRITE_LONG_ONCE        = 0x33,
       ATA_OP_WRITE_PIO_EXT          = 0x34,
       ATA_OP_WRITE_DMA_EXT          = 0x35,
+      ATA_OP_WRITE_DMA_FUA_EXT      = 0x3d,
       ATA_OP_WRITE_FPDMA            = 0x61,
       ATA_OP_READ_VERIFY            = 0x40,
       ATA_OP_READ_VERIFY_ONCE       = 0x41,
@@ -204,6 +205,32 @@ namespace sg
       ATA_OP_VENDOR_SPECIFIC_0x80   = 0x80,
     };
 
+  /*
+    SCT commands are written as a 512 byte block to log 0xE0 with
+    SMART WRITE LOG. For Error Recovery Control the time limits are in
+    units of 100ms.
+  */
+  enum
+    {
+      ATA_SMART_WRITE_LOG        = 0xd6,
+      ATA_SMART_LBAM             = 0x4f,
+      ATA_SMART_LBAH             = 0xc2,
+      ATA_LOG_SCT_COMMAND        = 0xe0,
+      SCT_ACTION_ERC             = 0x0003,
+      SCT_ERC_FUNCTION_SET       = 0x0001,
+      SCT_ERC_FUNCTION_GET       = 0x0002,
+      SCT_ERC_READ               = 0x0001,
+      SCT_ERC_WRITE              = 0x0002
+    };
+
+  enum
+    {
+      SCSI_OP_READ_16   = 0x88,
+      SCSI_OP_WRITE_16  = 0x8a,
+      SCSI_OP_VERIFY_16 = 0x8f,
+      SCSI_CDB1_FUA     = 0x08
+    };
+
   enum
     {
       SG_CDB2_TLEN_NODATA   = 0 << 0,
@@ -277,6 +304,8 @@ namespace sg
     uint64_t supports_sata_gen2:1;
     uint64_t supports_sata_gen3:1;
     uint64_t trim_supported:1;
+    uint64_t sct_supported:1;
+    uint64_t sct_erc_supported:1;
 
     uint8_t  form_factor;
     uint32_t rpm;
@@ -311,16 +340,61 @@ namespace sg
              const uint64_t  blocks,
              void           *buf,
              const size_t    buflen,
+             const int       dma,
              const int       timeout);
 
+  int
+  verify_block(const int      fd,
+               const uint64_t lba,
+               const uint64_t blocks,
+               const int      timeout);
+
   int
   write_block(const int       fd,
               const uint64_t  lba,
               const uint64_t  blocks,
               const void     *buf,
               const size_t    buflen,
+              const int       dma,
+              const bool      fua,
               const int       timeout);
 
+  int
+  scsi_read_block(const int       fd,
+                  const uint64_t  lba,
+                  const uint64_t  blocks,
+                  void           *buf,
+                  const size_t    buflen,
+                  const bool      fua,
+                  const int       timeout);
+
+  int
+  scsi_write_block(const int       fd,
+                   const uint64_t  lba,
+                   const uint64_t  blocks,
+                   const void     *buf,
+                   const size_t    buflen,
+                   const bool      fua,
+                   const int       timeout);
+
+  int
+  scsi_verify_block(const int      fd,
+                    const uint64_t lba,
+                    const uint64_t blocks,
+                    const int      timeout);
+
+  int
+  sct_erc_get(const int  fd,
+              const int  selection,
+              uint16_t  *deciseconds,
+              const int  timeout);
+
+  int
+  sct_erc_set(const int      fd,
+              const int      selection,
+              const uint16_t deciseconds,
+              const int      timeout);
+
   int
   write_uncorrectable(const int      fd,
                       const uint64_t lba,
@@ -0,0 +1,528 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "sensedata.hpp"
+#include "simdev.hpp"
+#include "time.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* UNRECOVERED READ ERROR and WRITE ERROR */
+#define SIM_READ_ERROR  (-SenseData::asc_ascq_to_errno(0x11,0x00))
+#define SIM_WRITE_ERROR (-SenseData::asc_ascq_to_errno(0x0C,0x00))
+
+namespace l
+{
+  static
+  void
+  split(const std::string        &str_,
+        const char                delim_,
+        std::vector<std::string> &parts_)
+  {
+    std::string part;
+    std::istringstream ss(str_);
+
+    while(std::getline(ss,part,delim_))
+      parts_.push_back(part);
+  }
+
+  static
+  int
+  parse_u64(const std::string &str_,
+            uint64_t          *value_)
+  {
+    char *end;
+
+    if(str_.empty())
+      return -EINVAL;
+
+    errno   = 0;
+    *value_ = ::strtoull(str_.c_str(),&end,10);
+    if((errno != 0) || (*end != '\0'))
+      return -EINVAL;
+
+    return 0;
+  }
+
+  static
+  int
+  parse_double(const std::string &str_,
+               double            *value_)
+  {
+    char *end;
+
+    if(str_.empty())
+      return -EINVAL;
+
+    errno   = 0;
+    *value_ = ::strtod(str_.c_str(),&end);
+    if((errno != 0) || (*end != '\0') || (*value_ < 0))
+      return -EINVAL;
+
+    return 0;
+  }
+
+  /*
+    Bytes with an optional K, M, G, or T (powers of 1024) suffix.
+  */
+  static
+  int
+  parse_size(std::string  str_,
+             uint64_t    *value_)
+  {
+    int rv;
+    uint64_t mult;
+
+    mult = 1;
+    if(!str_.empty())
+      {
+        switch(str_[str_.size() - 1])
+          {
+          case 'K': case 'k': mult = (1ULL << 10); break;
+          case 'M': case 'm': mult = (1ULL << 20); break;
+          case 'G': case 'g': mult = (1ULL << 30); break;
+          case 'T': case 't': mult = (1ULL << 40); break;
+          }
+        if(mult != 1)
+          str_.erase(str_.size() - 1);
+      }
+
+    rv = l::parse_u64(str_,value_);
+    if(rv < 0)
+      return rv;
+
+    *value_ *= mult;
+
+    return 0;
+  }
+
+  /*
+    Milliseconds: `N` fixed, `A-B` uniformly distributed, or `~M`
+    exponentially distributed with mean M.
+  */
+  static
+  int
+  parse_latency(const std::string &str_,
+                SimDev::Latency   *latency_)
+  {
+    int rv;
+    size_t dash;
+
+    latency_->a = 0;
+    latency_->b = 0;
+    if(!str_.empty() && (str_[0] == '~'))
+      {
+        latency_->type = SimDev::Latency::EXPONENTIAL;
+        rv = l::parse_double(str_.substr(1),&latency_->a);
+      }
+    else if((dash = str_.find('-')) != std::string::npos)
+      {
+        latency_->type = SimDev::Latency::UNIFORM;
+        rv = l::parse_double(str_.substr(0,dash),&latency_->a);
+        if(rv == 0)
+          rv = l::parse_double(str_.substr(dash + 1),&latency_->b);
+        if((rv == 0) && (latency_->b < latency_->a))
+          rv = -EINVAL;
+      }
+    else
+      {
+        latency_->type = SimDev::Latency::FIXED;
+        rv = l::parse_double(str_,&latency_->a);
+      }
+
+    latency_->a /= 1000.0;
+    latency_->b /= 1000.0;
+
+    return rv;
+  }
+
+  /*
+    `first[-last][@latency]` with `last` inclusive.
+  */
+  static
+  int
+  parse_range(const std::string &str_,
+              SimDev::Range     *range_)
+  {
+    int rv;
+    size_t at;
+    size_t dash;
+    std::string lbas;
+
+    range_->latency.type = SimDev::Latency::FIXED;
+    range_->latency.a    = 0;
+    range_->latency.b    = 0;
+
+    at   = str_.find('@');
+    lbas = str_.substr(0,at);
+    if(at != std::string::npos)
+      {
+        rv = l::parse_latency(str_.substr(at + 1),&range_->latency);
+        if(rv < 0)
+          return rv;
+      }
+
+    dash = lbas.find('-');
+    rv = l::parse_u64(lbas.substr(0,dash),&range_->start);
+    if(rv < 0)
+      return rv;
+
+    range_->end = range_->start;
+    if(dash != std::string::npos)
+      {
+        rv = l::parse_u64(lbas.substr(dash + 1),&range_->end);
+        if(rv < 0)
+          return rv;
+      }
+
+    if(range_->end < range_->start)
+      return -EINVAL;
+    range_->end++;
+
+    return 0;
+  }
+
+  static
+  bool
+  zeroed(const char     *buf_,
+         const uint64_t  len_)
+  {
+    for(uint64_t i = 0; i < len_; i++)
+      if(buf_[i] != 0)
+        return false;
+
+    return true;
+  }
+}
+
+SimDev::SimDev()
+  : _mutex(PTHREAD_MUTEX_INITIALIZER),
+    _busy_until(0),
+    _rng(1)
+{
+
+}
+
+SimDev::~SimDev()
+{
+
+}
+
+/*
+  Comma separated `key=value` pairs:
+
+  size=<bytes>[K|M|G|T] lbs=<bytes> pbs=<bytes> rate=<MB/s> lat=<ms>
+  seed=<n> bad=<range> wbad=<range> slow=<range> flip=<range>
+
+  where ranges are `first[-last][@latency]` and may be repeated.
+*/
+int
+SimDev::parse(const std::string &str_,
+              Spec              *spec_)
+{
+  int rv;
+  Range range;
+  std::string key;
+  std::string value;
+  std::vector<std::string> parts;
+
+  spec_->size                = (1ULL << 30);
+  spec_->logical_block_size  = 512;
+  spec_->physical_block_size = 4096;
+  spec_->rate                = 0;
+  spec_->latency             = 0;
+  spec_->seed                = 1;
+  spec_->bad.clear();
+  spec_->wbad.clear();
+  spec_->slow.clear();
+  spec_->flip.clear();
+
+  l::split(str_,',',parts);
+  for(size_t i = 0; i < parts.size(); i++)
+    {
+      size_t eq;
+
+      eq = parts[i].find('=');
+      if(eq == std::string::npos)
+        return -EINVAL;
+
+      key   = parts[i].substr(0,eq);
+      value = parts[i].substr(eq + 1);
+      if(key == "size")
+        rv = l::parse_size(value,&spec_->size);
+      else if(key == "lbs")
+        rv = l::parse_size(value,&spec_->logical_block_size);
+      else if(key == "pbs")
+        rv = l::parse_size(value,&spec_->physical_block_size);
+      else if(key == "rate")
+        rv = l::parse_double(value,&spec_->rate);
+      else if(key == "lat")
+        rv = l::parse_double(value,&spec_->latency);
+      else if(key == "seed")
+        rv = l::parse_u64(value,&spec_->seed);
+      else if((key == "bad") || (key == "wbad") || (key == "slow") || (key == "flip"))
+        rv = l::parse_range(value,&range);
+      else
+        rv = -EINVAL;
+      if(rv < 0)
+        return rv;
+
+      if(key == "bad")
+        spec_->bad.push_back(range);
+      else if(key == "wbad")
+        spec_->wbad.push_back(range);
+      else if(key == "slow")
+        spec_->slow.push_back(range);
+      else if(key == "flip")
+        spec_->flip.push_back(range);
+    }
+
+  spec_->latency /= 1000.0;
+
+  if((spec_->logical_block_size < 512) ||
+     (spec_->logical_block_size & (spec_->logical_block_size - 1)))
+    return -EINVAL;
+  if((spec_->physical_block_size < spec_->logical_block_size) ||
+     (spec_->physical_block_size % spec_->logical_block_size))
+    return -EINVAL;
+  if(spec_->size < spec_->physical_block_size)
+    return -EINVAL;
+
+  spec_->size = ((spec_->size / spec_->physical_block_size) *
+                 spec_->physical_block_size);
+
+  return 0;
+}
+
+int
+SimDev::init(const std::string &str_)
+{
+  int rv;
+
+  rv = SimDev::parse(str_,&_spec);
+  if(rv < 0)
+    return rv;
+
+  _bad.clear();
+  _wbad.clear();
+  _flip.clear();
+  _store.clear();
+  for(size_t i = 0; i < _spec.bad.size(); i++)
+    _bad.add(_spec.bad[i].start,_spec.bad[i].end);
+  for(size_t i = 0; i < _spec.wbad.size(); i++)
+    _wbad.add(_spec.wbad[i].start,_spec.wbad[i].end);
+  for(size_t i = 0; i < _spec.flip.size(); i++)
+    _flip.add(_spec.flip[i].start,_spec.flip[i].end);
+
+  _busy_until = 0;
+  _rng        = (_spec.seed ^ 0x9E3779B97F4A7C15ULL);
+  if(_rng == 0)
+    _rng = 1;
+
+  return 0;
+}
+
+/*
+  xorshift64* scaled to [0,1). Deterministic for a given seed so runs
+  with a single thread are repeatable.
+*/
+double
+SimDev::_random(void)
+{
+  _rng ^= (_rng >> 12);
+  _rng ^= (_rng << 25);
+  _rng ^= (_rng >> 27);
+
+  return (((_rng * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+double
+SimDev::_latency(const Latency &latency_)
+{
+  switch(latency_.type)
+    {
+    case Latency::FIXED:
+      return latency_.a;
+    case Latency::UNIFORM:
+      return (latency_.a + ((latency_.b - latency_.a) * _random()));
+    case Latency::EXPONENTIAL:
+      return (-latency_.a * std::log(1.0 - _random()));
+    }
+
+  return 0;
+}
+
+double
+SimDev::_range_latency(const std::vector<Range> &ranges_,
+                       const uint64_t            start_,
+                       const uint64_t            end_)
+{
+  double rv;
+
+  rv = 0;
+  for(size_t i = 0; i < ranges_.size(); i++)
+    if((ranges_[i].start < end_) && (start_ < ranges_[i].end))
+      rv += _latency(ranges_[i].latency);
+
+  return rv;
+}
+
+/*
+  Queue the command behind whatever the device is already busy with
+  and return how long the caller has to wait for it to complete.
+*/
+double
+SimDev::_schedule(const double   extra_,
+                  const uint64_t bytes_)
+{
+  double now;
+  double secs;
+
+  secs = (_spec.latency + extra_);
+  if(_spec.rate > 0)
+    secs += (bytes_ / (_spec.rate * 1000000.0));
+  if(secs <= 0)
+    return 0;
+
+  now         = Time::get_monotonic();
+  _busy_until = (std::max(_busy_until,now) + secs);
+
+  return (_busy_until - now);
+}
+
+int64_t
+SimDev::read(const uint64_t  lba_,
+             const uint64_t  blocks_,
+             void           *buf_,
+             const uint64_t  buflen_)
+{
+  int64_t rv;
+  double extra;
+  double wait;
+  uint64_t end;
+  uint64_t blocks;
+  Store::const_iterator i;
+  char *buf = (char*)buf_;
+  const uint64_t lbs   = _spec.logical_block_size;
+  const uint64_t count = (_spec.size / lbs);
+
+  if(lba_ >= count)
+    return 0;
+
+  blocks = std::min(std::min(blocks_,count - lba_),(buflen_ / lbs));
+  end    = (lba_ + blocks);
+
+  pthread_mutex_lock(&_mutex);
+  extra = _range_latency(_spec.slow,lba_,end);
+  if(_bad.intersects(lba_,end) || _wbad.intersects(lba_,end))
+    {
+      extra += _range_latency(_spec.bad,lba_,end);
+      extra += _range_latency(_spec.wbad,lba_,end);
+      rv     = SIM_READ_ERROR;
+    }
+  else
+    {
+      ::memset(buf,0,blocks * lbs);
+      for(i = _store.lower_bound(lba_); (i != _store.end()) && (i->first < end); ++i)
+        ::memcpy(&buf[(i->first - lba_) * lbs],&i->second[0],lbs);
+      extra += _range_latency(_spec.flip,lba_,end);
+      for(uint64_t b = lba_; b < end; b++)
+        if(_flip.contains(b))
+          buf[((b - lba_) * lbs) + (b % lbs)] ^= (1 << (b % 8));
+      rv = blocks;
+    }
+  wait = _schedule(extra,((rv > 0) ? (blocks * lbs) : 0));
+  pthread_mutex_unlock(&_mutex);
+
+  if(wait > 0)
+    Time::sleep(wait);
+
+  return rv;
+}
+
+int64_t
+SimDev::write(const uint64_t  lba_,
+              const uint64_t  blocks_,
+              const void     *buf_,
+              const uint64_t  buflen_)
+{
+  int64_t rv;
+  double extra;
+  double wait;
+  uint64_t end;
+  uint64_t blocks;
+  const char *buf = (const char*)buf_;
+  const uint64_t lbs   = _spec.logical_block_size;
+  const uint64_t count = (_spec.size / lbs);
+
+  if(lba_ >= count)
+    return -ENOSPC;
+
+  blocks = std::min(std::min(blocks_,count - lba_),(buflen_ / lbs));
+  end    = (lba_ + blocks);
+
+  pthread_mutex_lock(&_mutex);
+  extra = _range_latency(_spec.slow,lba_,end);
+  if(_wbad.intersects(lba_,end))
+    {
+      extra += _range_latency(_spec.wbad,lba_,end);
+      rv     = SIM_WRITE_ERROR;
+    }
+  else
+    {
+      for(uint64_t b = 0; b < blocks; b++)
+        {
+          const char *p = &buf[b * lbs];
+
+          if(l::zeroed(p,lbs))
+            _store.erase(lba_ + b);
+          else
+            _store[lba_ + b].assign(p,p + lbs);
+        }
+      _bad.remove(lba_,end);
+      rv = blocks;
+    }
+  wait = _schedule(extra,((rv > 0) ? (blocks * lbs) : 0));
+  pthread_mutex_unlock(&_mutex);
+
+  if(wait > 0)
+    Time::sleep(wait);
+
+  return rv;
+}
+
+/*
+  Write uncorrectable: the block fails to read until next written.
+*/
+void
+SimDev::mark_bad(const uint64_t lba_)
+{
+  pthread_mutex_lock(&_mutex);
+  _bad.add(lba_);
+  pthread_mutex_unlock(&_mutex);
+}
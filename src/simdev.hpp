@@ -0,0 +1,125 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include "blockranges.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stdint.h>
+
+/*
+  An in memory stand in for a block device so that scans, burnins,
+  and fixes can be run against known bad, slow, and unwritable ranges
+  and timed repeatably. Commands are serviced one at a time like a
+  single actuator drive: each takes `lat` plus its transfer time at
+  `rate` plus the latency of any special range it touches.
+
+  Blocks in `bad` ranges fail to read until written, like pending
+  sectors which a write reallocates. Blocks in `wbad` ranges fail both
+  reads and writes. Blocks in `flip` ranges read without error but
+  with a bit flipped, like silent corruption. Written data is kept so
+  it reads back, all zero blocks aren't stored.
+*/
+
+class SimDev
+{
+public:
+  struct Latency
+  {
+    enum Type
+      {
+        FIXED,
+        UNIFORM,
+        EXPONENTIAL
+      };
+
+    Type   type;
+    double a;
+    double b;
+  };
+
+  struct Range
+  {
+    uint64_t start;
+    uint64_t end;
+    Latency  latency;
+  };
+
+  struct Spec
+  {
+    uint64_t           size;
+    uint64_t           logical_block_size;
+    uint64_t           physical_block_size;
+    double             rate;
+    double             latency;
+    uint64_t           seed;
+    std::vector<Range> bad;
+    std::vector<Range> wbad;
+    std::vector<Range> slow;
+    std::vector<Range> flip;
+  };
+
+public:
+  SimDev();
+  ~SimDev();
+
+public:
+  static int parse(const std::string &str,
+                   Spec              *spec);
+
+public:
+  int init(const std::string &str);
+  const Spec &spec(void) const { return _spec; }
+
+public:
+  int64_t read(const uint64_t  lba,
+               const uint64_t  blocks,
+               void           *buf,
+               const uint64_t  buflen);
+  int64_t write(const uint64_t  lba,
+                const uint64_t  blocks,
+                const void     *buf,
+                const uint64_t  buflen);
+  void mark_bad(const uint64_t lba);
+
+private:
+  double _random(void);
+  double _latency(const Latency &latency);
+  double _range_latency(const std::vector<Range> &ranges,
+                        const uint64_t            start,
+                        const uint64_t            end);
+  double _schedule(const double   extra,
+                   const uint64_t bytes);
+
+private:
+  typedef std::map<uint64_t,std::vector<char> > Store;
+
+  pthread_mutex_t _mutex;
+  Spec            _spec;
+  BlockRanges     _bad;
+  BlockRanges     _wbad;
+  BlockRanges     _flip;
+  Store           _store;
+  double          _busy_until;
+  uint64_t        _rng;
+};
@@ -16,6 +16,10 @@
   OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 */
 
+#include "signals.hpp"
+#include "time.hpp"
+
+#include <errno.h>
 #include <time.h>
 
 namespace Time
@@ -29,4 +33,25 @@ namespace Time
 
     return ((double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0));
   }
+
+  /*
+    Sleep for `secs_` regardless of the progress alarm and other
+    signals interrupting it unless told to exit.
+  */
+  void
+  sleep(const double secs_)
+  {
+    int rv;
+    struct timespec req;
+    struct timespec rem;
+
+    req.tv_sec  = (time_t)secs_;
+    req.tv_nsec = (long)((secs_ - req.tv_sec) * 1000000000.0);
+    do
+      {
+        rv = ::nanosleep(&req,&rem);
+        req = rem;
+      }
+    while((rv == -1) && (errno == EINTR) && !signals::signaled_to_exit());
+  }
 }
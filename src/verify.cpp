@@ -0,0 +1,438 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include "verify.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define VERIFY_X86
+#endif
+
+namespace l
+{
+  static
+  inline
+  uint64_t
+  load64(const char *p_)
+  {
+    uint64_t v;
+
+    ::memcpy(&v,p_,sizeof(v));
+
+    return v;
+  }
+
+  static
+  bool
+  equal_c(const uint8_t   byte_,
+          const char     *buf_,
+          const uint64_t  len_)
+  {
+    uint64_t i;
+    uint64_t diff;
+    const uint64_t pattern = (byte_ * 0x0101010101010101ULL);
+
+    diff = 0;
+    for(i = 0; (i + 8) <= len_; i += 8)
+      diff |= (l::load64(&buf_[i]) ^ pattern);
+    for(; i < len_; i++)
+      diff |= ((uint8_t)buf_[i] ^ byte_);
+
+    return (diff == 0);
+  }
+
+  static
+  bool
+  equal_buf_c(const char     *a_,
+              const char     *b_,
+              const uint64_t  len_)
+  {
+    uint64_t i;
+    uint64_t diff;
+
+    diff = 0;
+    for(i = 0; (i + 8) <= len_; i += 8)
+      diff |= (l::load64(&a_[i]) ^ l::load64(&b_[i]));
+    for(; i < len_; i++)
+      diff |= (uint8_t)(a_[i] ^ b_[i]);
+
+    return (diff == 0);
+  }
+
+  static
+  uint64_t
+  flipped_bits_c(const char     *a_,
+                 const char     *b_,
+                 const uint64_t  len_)
+  {
+    uint64_t i;
+    uint64_t bits;
+
+    bits = 0;
+    for(i = 0; (i + 8) <= len_; i += 8)
+      bits += __builtin_popcountll(l::load64(&a_[i]) ^ l::load64(&b_[i]));
+    for(; i < len_; i++)
+      bits += __builtin_popcount((uint8_t)(a_[i] ^ b_[i]));
+
+    return bits;
+  }
+
+  static
+  uint64_t
+  flipped_bits_byte_c(const uint8_t   byte_,
+                      const char     *buf_,
+                      const uint64_t  len_)
+  {
+    uint64_t i;
+    uint64_t bits;
+    const uint64_t pattern = (byte_ * 0x0101010101010101ULL);
+
+    bits = 0;
+    for(i = 0; (i + 8) <= len_; i += 8)
+      bits += __builtin_popcountll(l::load64(&buf_[i]) ^ pattern);
+    for(; i < len_; i++)
+      bits += __builtin_popcount((uint8_t)buf_[i] ^ byte_);
+
+    return bits;
+  }
+
+#ifdef VERIFY_X86
+  static
+  bool
+  equal_sse2(const uint8_t   byte_,
+             const char     *buf_,
+             const uint64_t  len_)
+  {
+    uint64_t i;
+    __m128i diff;
+    const __m128i pattern = _mm_set1_epi8(byte_);
+
+    for(i = 0; (i + 64) <= len_; i += 64)
+      {
+        diff = _mm_or_si128(_mm_or_si128(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&buf_[i+ 0]),pattern),
+                                         _mm_xor_si128(_mm_loadu_si128((const __m128i*)&buf_[i+16]),pattern)),
+                            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&buf_[i+32]),pattern),
+                                         _mm_xor_si128(_mm_loadu_si128((const __m128i*)&buf_[i+48]),pattern)));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(diff,_mm_setzero_si128())) != 0xFFFF)
+          return false;
+      }
+
+    return l::equal_c(byte_,&buf_[i],len_ - i);
+  }
+
+  static
+  bool
+  equal_buf_sse2(const char     *a_,
+                 const char     *b_,
+                 const uint64_t  len_)
+  {
+    uint64_t i;
+    __m128i diff;
+
+    for(i = 0; (i + 64) <= len_; i += 64)
+      {
+        diff = _mm_or_si128(_mm_or_si128(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&a_[i+ 0]),
+                                                       _mm_loadu_si128((const __m128i*)&b_[i+ 0])),
+                                         _mm_xor_si128(_mm_loadu_si128((const __m128i*)&a_[i+16]),
+                                                       _mm_loadu_si128((const __m128i*)&b_[i+16]))),
+                            _mm_or_si128(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&a_[i+32]),
+                                                       _mm_loadu_si128((const __m128i*)&b_[i+32])),
+                                         _mm_xor_si128(_mm_loadu_si128((const __m128i*)&a_[i+48]),
+                                                       _mm_loadu_si128((const __m128i*)&b_[i+48]))));
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(diff,_mm_setzero_si128())) != 0xFFFF)
+          return false;
+      }
+
+    return l::equal_buf_c(&a_[i],&b_[i],len_ - i);
+  }
+
+  /*
+    SSE2 has no byte shuffle so bits are counted SWAR style within
+    each byte and summed into 64bit lanes.
+  */
+  static
+  inline
+  __m128i
+  popcount_sse2(__m128i v_)
+  {
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+
+    v_ = _mm_sub_epi8(v_,_mm_and_si128(_mm_srli_epi16(v_,1),m1));
+    v_ = _mm_add_epi8(_mm_and_si128(v_,m2),_mm_and_si128(_mm_srli_epi16(v_,2),m2));
+    v_ = _mm_and_si128(_mm_add_epi8(v_,_mm_srli_epi16(v_,4)),m4);
+
+    return _mm_sad_epu8(v_,_mm_setzero_si128());
+  }
+
+  static
+  uint64_t
+  sum_sse2(const __m128i v_)
+  {
+    return ((uint64_t)_mm_cvtsi128_si64(v_) +
+            (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(v_,v_)));
+  }
+
+  static
+  uint64_t
+  flipped_bits_sse2(const char     *a_,
+                    const char     *b_,
+                    const uint64_t  len_)
+  {
+    uint64_t i;
+    __m128i sum;
+
+    sum = _mm_setzero_si128();
+    for(i = 0; (i + 16) <= len_; i += 16)
+      sum = _mm_add_epi64(sum,
+                          l::popcount_sse2(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&a_[i]),
+                                                         _mm_loadu_si128((const __m128i*)&b_[i]))));
+
+    return (l::sum_sse2(sum) + l::flipped_bits_c(&a_[i],&b_[i],len_ - i));
+  }
+
+  static
+  uint64_t
+  flipped_bits_byte_sse2(const uint8_t   byte_,
+                         const char     *buf_,
+                         const uint64_t  len_)
+  {
+    uint64_t i;
+    __m128i sum;
+    const __m128i pattern = _mm_set1_epi8(byte_);
+
+    sum = _mm_setzero_si128();
+    for(i = 0; (i + 16) <= len_; i += 16)
+      sum = _mm_add_epi64(sum,
+                          l::popcount_sse2(_mm_xor_si128(_mm_loadu_si128((const __m128i*)&buf_[i]),
+                                                         pattern)));
+
+    return (l::sum_sse2(sum) + l::flipped_bits_byte_c(byte_,&buf_[i],len_ - i));
+  }
+
+  __attribute__((target("avx2")))
+  static
+  bool
+  equal_avx2(const uint8_t   byte_,
+             const char     *buf_,
+             const uint64_t  len_)
+  {
+    uint64_t i;
+    __m256i diff;
+    const __m256i pattern = _mm256_set1_epi8(byte_);
+
+    for(i = 0; (i + 128) <= len_; i += 128)
+      {
+        diff = _mm256_or_si256(_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&buf_[i+ 0]),pattern),
+                                               _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&buf_[i+32]),pattern)),
+                               _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&buf_[i+64]),pattern),
+                                               _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&buf_[i+96]),pattern)));
+        if(!_mm256_testz_si256(diff,diff))
+          return false;
+      }
+
+    return l::equal_c(byte_,&buf_[i],len_ - i);
+  }
+
+  __attribute__((target("avx2")))
+  static
+  bool
+  equal_buf_avx2(const char     *a_,
+                 const char     *b_,
+                 const uint64_t  len_)
+  {
+    uint64_t i;
+    __m256i diff;
+
+    for(i = 0; (i + 128) <= len_; i += 128)
+      {
+        diff = _mm256_or_si256(_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&a_[i+ 0]),
+                                                                _mm256_loadu_si256((const __m256i*)&b_[i+ 0])),
+                                               _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&a_[i+32]),
+                                                                _mm256_loadu_si256((const __m256i*)&b_[i+32]))),
+                               _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&a_[i+64]),
+                                                                _mm256_loadu_si256((const __m256i*)&b_[i+64])),
+                                               _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&a_[i+96]),
+                                                                _mm256_loadu_si256((const __m256i*)&b_[i+96]))));
+        if(!_mm256_testz_si256(diff,diff))
+          return false;
+      }
+
+    return l::equal_buf_c(&a_[i],&b_[i],len_ - i);
+  }
+
+  /*
+    Per byte popcount via a nibble lookup, summed into 64bit lanes.
+  */
+  __attribute__((target("avx2")))
+  static
+  inline
+  __m256i
+  popcount_avx2(const __m256i v_)
+  {
+    const __m256i lut  = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                          0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i lo;
+    __m256i hi;
+
+    lo = _mm256_shuffle_epi8(lut,_mm256_and_si256(v_,mask));
+    hi = _mm256_shuffle_epi8(lut,_mm256_and_si256(_mm256_srli_epi16(v_,4),mask));
+
+    return _mm256_sad_epu8(_mm256_add_epi8(lo,hi),_mm256_setzero_si256());
+  }
+
+  __attribute__((target("avx2")))
+  static
+  uint64_t
+  sum_avx2(const __m256i v_)
+  {
+    return ((uint64_t)_mm256_extract_epi64(v_,0) +
+            (uint64_t)_mm256_extract_epi64(v_,1) +
+            (uint64_t)_mm256_extract_epi64(v_,2) +
+            (uint64_t)_mm256_extract_epi64(v_,3));
+  }
+
+  __attribute__((target("avx2")))
+  static
+  uint64_t
+  flipped_bits_avx2(const char     *a_,
+                    const char     *b_,
+                    const uint64_t  len_)
+  {
+    uint64_t i;
+    __m256i sum;
+
+    sum = _mm256_setzero_si256();
+    for(i = 0; (i + 32) <= len_; i += 32)
+      sum = _mm256_add_epi64(sum,
+                             l::popcount_avx2(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&a_[i]),
+                                                               _mm256_loadu_si256((const __m256i*)&b_[i]))));
+
+    return (l::sum_avx2(sum) + l::flipped_bits_c(&a_[i],&b_[i],len_ - i));
+  }
+
+  __attribute__((target("avx2")))
+  static
+  uint64_t
+  flipped_bits_byte_avx2(const uint8_t   byte_,
+                         const char     *buf_,
+                         const uint64_t  len_)
+  {
+    uint64_t i;
+    __m256i sum;
+    const __m256i pattern = _mm256_set1_epi8(byte_);
+
+    sum = _mm256_setzero_si256();
+    for(i = 0; (i + 32) <= len_; i += 32)
+      sum = _mm256_add_epi64(sum,
+                             l::popcount_avx2(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)&buf_[i]),
+                                                               pattern)));
+
+    return (l::sum_avx2(sum) + l::flipped_bits_byte_c(byte_,&buf_[i],len_ - i));
+  }
+#endif
+
+  struct Impl
+  {
+    bool     (*equal)(const uint8_t,const char*,const uint64_t);
+    bool     (*equal_buf)(const char*,const char*,const uint64_t);
+    uint64_t (*flipped_bits)(const char*,const char*,const uint64_t);
+    uint64_t (*flipped_bits_byte)(const uint8_t,const char*,const uint64_t);
+  };
+
+  static
+  Impl
+  select(void)
+  {
+    Impl impl;
+
+    impl.equal             = l::equal_c;
+    impl.equal_buf         = l::equal_buf_c;
+    impl.flipped_bits      = l::flipped_bits_c;
+    impl.flipped_bits_byte = l::flipped_bits_byte_c;
+
+#ifdef VERIFY_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse2"))
+      {
+        impl.equal             = l::equal_sse2;
+        impl.equal_buf         = l::equal_buf_sse2;
+        impl.flipped_bits      = l::flipped_bits_sse2;
+        impl.flipped_bits_byte = l::flipped_bits_byte_sse2;
+      }
+    if(__builtin_cpu_supports("avx2"))
+      {
+        impl.equal             = l::equal_avx2;
+        impl.equal_buf         = l::equal_buf_avx2;
+        impl.flipped_bits      = l::flipped_bits_avx2;
+        impl.flipped_bits_byte = l::flipped_bits_byte_avx2;
+      }
+#endif
+
+    return impl;
+  }
+
+  static
+  const Impl&
+  impl(void)
+  {
+    static const Impl impl = l::select();
+
+    return impl;
+  }
+}
+
+namespace verify
+{
+  bool
+  equal(const uint8_t   byte_,
+        const char     *buf_,
+        const uint64_t  len_)
+  {
+    return l::impl().equal(byte_,buf_,len_);
+  }
+
+  bool
+  equal(const char     *a_,
+        const char     *b_,
+        const uint64_t  len_)
+  {
+    return l::impl().equal_buf(a_,b_,len_);
+  }
+
+  uint64_t
+  flipped_bits(const char     *a_,
+               const char     *b_,
+               const uint64_t  len_)
+  {
+    return l::impl().flipped_bits(a_,b_,len_);
+  }
+
+  uint64_t
+  flipped_bits(const uint8_t   byte_,
+               const char     *buf_,
+               const uint64_t  len_)
+  {
+    return l::impl().flipped_bits_byte(byte_,buf_,len_);
+  }
+}
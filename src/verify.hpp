@@ -0,0 +1,50 @@
+/*
+  ISC License
+
+  Copyright (c) 2026, Antonio SJ Musumeci <trapexit@spawn.link>
+
+  Permission to use, copy, modify, and/or distribute this software for any
+  purpose with or without fee is hereby granted, provided that the above
+  copyright notice and this permission notice appear in all copies.
+
+  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+  Buffer comparison used when verifying burnin reads. The widest
+  implementation the CPU supports (AVX2, SSE2, or plain C) is picked
+  on first use.
+*/
+
+namespace verify
+{
+  bool
+  equal(const uint8_t   byte,
+        const char     *buf,
+        const uint64_t  len);
+
+  bool
+  equal(const char     *a,
+        const char     *b,
+        const uint64_t  len);
+
+  uint64_t
+  flipped_bits(const char     *a,
+               const char     *b,
+               const uint64_t  len);
+
+  uint64_t
+  flipped_bits(const uint8_t   byte,
+               const char     *buf,
+               const uint64_t  len);
+}